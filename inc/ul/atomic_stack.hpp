@@ -0,0 +1,224 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_ATOMIC_STACK__HPP_
+#define UL_ATOMIC_STACK__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/debug.hpp>
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Defines a raw atomic stack hook, the link to the element below this
+ *        one. Copies start unlinked.
+ */
+struct atomic_stack_node {
+	atomic_stack_node()
+		: next(nullptr)
+	{ }
+
+	atomic_stack_node(atomic_stack_node const&)
+		: next(nullptr)
+	{ }
+
+	atomic_stack_node& operator=(atomic_stack_node const&)
+	{
+		return *this;
+	}
+
+
+	std::atomic<atomic_stack_node*> next;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+//
+// Top of the stack, swapped together with a tag bumped on every change so
+// that a pop racing with others cannot mistake a node popped and pushed back
+// for the one it read
+//
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+class atomic_stack_head {
+	typedef unsigned __int128 word_type;
+
+public:
+	atomic_stack_head()
+	{
+		_word[0] = 0;
+		_word[1] = 0;
+	}
+
+	//
+	// The halves are read apart, a torn read only makes the next swap fail
+	//
+	atomic_stack_node* load(uint64& tag) const
+	{
+		tag = __atomic_load_n(&_word[1], __ATOMIC_ACQUIRE);
+		return reinterpret_cast<atomic_stack_node*>(__atomic_load_n(&_word[0], __ATOMIC_ACQUIRE));
+	}
+
+	bool compare_exchange(atomic_stack_node* node, uint64 tag, atomic_stack_node* desired)
+	{
+		word_type expected = word_type(tag) << 64 | uintptr(node);
+		word_type value    = word_type(tag + 1) << 64 | uintptr(desired);
+
+		return __sync_bool_compare_and_swap(reinterpret_cast<word_type*>(_word), expected, value);
+	}
+
+private:
+	alignas(16) uint64 _word[2];
+};
+#else
+//
+// Without a double word swap the tag takes the top half of the word on 32
+// bit targets, and the top 16 bits left unused by 48 bit addresses on 64 bit
+// ones
+//
+class atomic_stack_head {
+	static const uint   k_shift = sizeof(void*) == 4 ? 32 : 48;
+	static const uint64 k_mask  = (uint64(1) << k_shift) - 1;
+
+public:
+	atomic_stack_head()
+		: _word(0)
+	{ }
+
+	atomic_stack_node* load(uint64& tag) const
+	{
+		uint64 word = _word.load(std::memory_order_acquire);
+
+		tag = word >> k_shift;
+		return reinterpret_cast<atomic_stack_node*>(uintptr(word & k_mask));
+	}
+
+	bool compare_exchange(atomic_stack_node* node, uint64 tag, atomic_stack_node* desired)
+	{
+		uint64 expected = tag << k_shift | uintptr(node);
+
+		UL_ASSERT(!(uintptr(desired) & ~k_mask));
+		return _word.compare_exchange_weak(expected, (tag + 1) << k_shift | uintptr(desired),
+			std::memory_order_acq_rel, std::memory_order_acquire);
+	}
+
+private:
+	std::atomic<uint64> _word;
+};
+#endif
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive lock-free LIFO stack (Treiber stack).
+ *
+ * Any thread may push and pop. The top of the stack is tagged against the
+ * ABA problem, with a 64 bit tag swapped along with it where double word
+ * compare and swap is available, a narrower one packed in the pointer word
+ * otherwise.
+ *
+ * pop() reads the link of the top element before swapping it out, so
+ * elements popped must stay readable while other threads may still pop,
+ * as when they are recycled through the stack rather than freed.
+ */
+template<class T, atomic_stack_node T::* NodeMember>
+class atomic_stack {
+	atomic_stack(const atomic_stack&);
+	atomic_stack& operator=(const atomic_stack&);
+
+public:
+	typedef T*       pointer;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	atomic_stack()
+	{ }
+
+	void push(reference elem)
+	{
+		atomic_stack_node* node = member_of(&elem, NodeMember);
+
+		for (;;) {
+			uint64             tag;
+			atomic_stack_node* top = _head.load(tag);
+
+			node->next.store(top, std::memory_order_relaxed);
+			if (_head.compare_exchange(top, tag, node))
+				return;
+		}
+	}
+
+	/**
+	 * Remove the top element, or return null if there is none.
+	 */
+	pointer pop()
+	{
+		for (;;) {
+			uint64             tag;
+			atomic_stack_node* top = _head.load(tag);
+
+			if (!top)
+				return nullptr;
+
+			if (_head.compare_exchange(top, tag, top->next.load(std::memory_order_relaxed)))
+				return parent_of(top, NodeMember);
+		}
+	}
+
+	/**
+	 * Detach every element at once and hand each one to \a f, top first.
+	 * Returns their number.
+	 */
+	template<class F>
+	size_t pop_all(F f)
+	{
+		uint64             tag;
+		atomic_stack_node* top;
+
+		do {
+			top = _head.load(tag);
+			if (!top)
+				return 0;
+		} while (!_head.compare_exchange(top, tag, nullptr));
+
+		size_t n = 0;
+
+		while (top) {
+			atomic_stack_node* next = top->next.load(std::memory_order_relaxed);
+
+			f(parent_of(top, NodeMember));
+			top = next;
+			++n;
+		}
+
+		return n;
+	}
+
+	bool empty() const
+	{
+		uint64 tag;
+
+		return !_head.load(tag);
+	}
+
+private:
+	detail::atomic_stack_head _head;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_ATOMIC_STACK__HPP_ */
@@ -30,12 +30,14 @@
 #	error "Unable to determine endianess, you must support/fix it"
 #endif
 
-#if defined(__clang__) || defined(__GCC__)
+#if defined(__clang__) || defined(__GNUC__)
 	#define UL_LIKELY(exp)   __builtin_expect(static_cast<bool>(exp), true)
 	#define UL_UNLIKELY(exp) __builtin_expect(static_cast<bool>(exp), false)
+	#define UL_PREFETCH(ptr) __builtin_prefetch(ptr)
 #else
 	#define UL_LIKELY(exp)   static_cast<bool>(exp)
 	#define UL_UNLIKELY(exp) static_cast<bool>(exp)
+	#define UL_PREFETCH(ptr) ((void) 0)
 #endif
 
 ///////////////////////////////////////////////////////////////////////////////
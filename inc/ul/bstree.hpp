@@ -0,0 +1,507 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_BSTREE__HPP_
+#define UL_BSTREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/rbtree.hpp>
+#include <ul/rbtree_node.hpp>
+#include <ul/rbtree_iterator.hpp>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+/**
+ * \brief Binary search tree primitives over rbtree_node links, shared by the
+ *        balancing schemes other than red-black.
+ */
+struct bstree_algorithms {
+	static void replace_child(rbtree_node** root, rbtree_node* old, rbtree_node* node)
+	{
+		rbtree_node* parent = old->parent();
+
+		if (!parent)
+			*root = node;
+		else if (parent->left == old)
+			parent->left = node;
+		else
+			parent->right = node;
+	}
+
+	static void rotate_left(rbtree_node** root, rbtree_node* node)
+	{
+		rbtree_node* tmp = node->right;
+
+		node->right = tmp->left;
+		if (tmp->left)
+			tmp->left->parent(node);
+		tmp->parent(node->parent());
+		replace_child(root, node, tmp);
+		tmp->left = node;
+		node->parent(tmp);
+	}
+
+	static void rotate_right(rbtree_node** root, rbtree_node* node)
+	{
+		rbtree_node* tmp = node->left;
+
+		node->left = tmp->right;
+		if (tmp->right)
+			tmp->right->parent(node);
+		tmp->parent(node->parent());
+		replace_child(root, node, tmp);
+		tmp->right = node;
+		node->parent(tmp);
+	}
+
+	/**
+	 * Rotate \a node above its parent.
+	 */
+	static void rotate_up(rbtree_node** root, rbtree_node* node)
+	{
+		rbtree_node* parent = node->parent();
+
+		if (parent->left == node)
+			rotate_right(root, parent);
+		else
+			rotate_left(root, parent);
+	}
+
+	static void link(rbtree_node* node, rbtree_node* parent, rbtree_node** next)
+	{
+		node->parent(parent);
+		node->bits(0);
+		node->left = nullptr;
+		node->right = nullptr;
+		*next = node;
+	}
+
+	/**
+	 * Unlink \a old, putting its successor in its place when it has two
+	 * children. Returns the node where the height of the tree may have
+	 * changed, or null, and sets \a left to the side of it that got shorter.
+	 * The successor takes over the bits of \a old.
+	 */
+	static rbtree_node* unlink(rbtree_node** root, rbtree_node* old, bool& left)
+	{
+		rbtree_node* parent;
+
+		if (old->left && old->right) {
+			rbtree_node* node = old->right->min();
+
+			if (node->parent() == old) {
+				parent = node;
+				left = false;
+			} else {
+				parent = node->parent();
+				left = true;
+				parent->left = node->right;
+				if (node->right)
+					node->right->parent(parent);
+				node->right = old->right;
+				old->right->parent(node);
+			}
+
+			node->left = old->left;
+			old->left->parent(node);
+			node->parent(old->parent());
+			node->bits(old->bits());
+			replace_child(root, old, node);
+		} else {
+			rbtree_node* child = old->left ? old->left : old->right;
+
+			parent = old->parent();
+			if (parent)
+				left = parent->left == old;
+			if (child)
+				child->parent(parent);
+			replace_child(root, old, child);
+		}
+
+		old->parent(nullptr);
+		old->left = nullptr;
+		old->right = nullptr;
+
+		return parent;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive binary search tree balanced by \a Algorithms, the common
+ *        part of avltree, splaytree and treap.
+ *
+ * Algorithms provides:
+ * - insert(root, node, parent, next): link \a node at \a next, below
+ *   \a parent, and rebalance;
+ * - remove(root, node): unlink \a node and rebalance;
+ * - access(root, node): called on the node a lookup ended at.
+ */
+template<class T, rbtree_node T::* NodeMember, class Compare, class Algorithms>
+class bstree {
+	bstree(const bstree&);
+	bstree& operator=(const bstree&);
+
+public:
+	typedef T*                                    pointer;
+	typedef T const*                              const_pointer;
+	typedef T&                                    reference;
+	typedef T const&                              const_reference;
+	typedef rbtree_iterator<T, NodeMember>        iterator;
+	typedef rbtree_iterator<T const, NodeMember>  const_iterator;
+	typedef std::reverse_iterator<iterator>       reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	iterator insert_equal(reference elem)
+	{
+		rbtree_node*  parent = nullptr;
+		rbtree_node** next   = &_root;
+		Compare       cmp;
+
+		while (*next) {
+			parent = *next;
+			if (cmp(elem, *parent_of(parent, NodeMember)))
+				next = &parent->left;
+			else
+				next = &parent->right;
+		}
+
+		return insert(member_of(&elem, NodeMember), parent, next);
+	}
+
+	std::pair<iterator, bool> insert_unique(reference elem)
+	{
+		rbtree_node*  parent = nullptr;
+		rbtree_node** next   = &_root;
+		Compare       cmp;
+
+		while (*next) {
+			parent = *next;
+
+			T& other = *parent_of(parent, NodeMember);
+
+			if (cmp(elem, other)) {
+				next = &parent->left;
+			} else if (cmp(other, elem)) {
+				next = &parent->right;
+			} else {
+				Algorithms::access(&_root, parent);
+				return std::pair<iterator, bool>(iterator(parent), false);
+			}
+		}
+
+		return std::pair<iterator, bool>(insert(member_of(&elem, NodeMember), parent, next), true);
+	}
+
+	template<class Key>
+	iterator find(Key const& key)
+	{
+		rbtree_node* last;
+		rbtree_node* n = find_impl(key, last);
+
+		if (last)
+			Algorithms::access(&_root, last);
+
+		return n ? iterator(n) : end();
+	}
+
+	template<class Key>
+	const_iterator find(Key const& key) const
+	{
+		rbtree_node* last;
+		rbtree_node* n = find_impl(key, last);
+
+		return n ? const_iterator(n) : end();
+	}
+
+	template<class Key>
+	iterator lower_bound(Key const& key)
+	{
+		return access(bound_impl<false>(key));
+	}
+
+	template<class Key>
+	const_iterator lower_bound(Key const& key) const
+	{
+		return make_iterator<const_iterator>(bound_impl<false>(key));
+	}
+
+	template<class Key>
+	iterator upper_bound(Key const& key)
+	{
+		return access(bound_impl<true>(key));
+	}
+
+	template<class Key>
+	const_iterator upper_bound(Key const& key) const
+	{
+		return make_iterator<const_iterator>(bound_impl<true>(key));
+	}
+
+	void remove(iterator i)
+	{
+		remove(*i);
+	}
+
+	void remove(reference elem)
+	{
+		rbtree_node* node = member_of(&elem, NodeMember);
+
+		if (node == _leftmost)
+			_leftmost = node->next();
+		if (node == _rightmost)
+			_rightmost = node->prev();
+
+		Algorithms::remove(&_root, node);
+		--_size;
+	}
+
+	template<class Key>
+	bool remove(Key const& key)
+	{
+		rbtree_node* last;
+		rbtree_node* n = find_impl(key, last);
+
+		if (!n)
+			return false;
+
+		remove(*parent_of(n, NodeMember));
+		return true;
+	}
+
+	/**
+	 * Unlink every element, in O(n) and without rebalancing.
+	 */
+	void clear()
+	{
+		clear_and_dispose(null_disposer());
+	}
+
+	/**
+	 * Unlink every element in post-order, handing each one to \a disposer
+	 * once it is unlinked. Takes O(n) time.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		rbtree_node* node = _root;
+		rbtree_node* parent;
+
+		_root = nullptr;
+		_leftmost = nullptr;
+		_rightmost = nullptr;
+		_size = 0;
+
+		while (node) {
+			if (node->left) {
+				node = node->left;
+			} else if (node->right) {
+				node = node->right;
+			} else {
+				parent = node->parent();
+				if (parent) {
+					if (parent->left == node)
+						parent->left = nullptr;
+					else
+						parent->right = nullptr;
+				}
+				node->parent(nullptr);
+				disposer(parent_of(node, NodeMember));
+				node = parent;
+			}
+		}
+	}
+
+	bool empty() const
+	{
+		return !_root;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	void swap(bstree& other)
+	{
+		std::swap(_root, other._root);
+		std::swap(_leftmost, other._leftmost);
+		std::swap(_rightmost, other._rightmost);
+		std::swap(_size, other._size);
+	}
+
+	//
+	// As in rbtree, the first and last nodes are cached, the end iterator is
+	// the last node tagged as out of range
+	//
+	iterator begin()
+	{
+		return iterator(_leftmost);
+	}
+
+	iterator end()
+	{
+		return _rightmost ? iterator(_rightmost, rbtree_out_of_range_tag()) : iterator();
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(_leftmost);
+	}
+
+	const_iterator end() const
+	{
+		return _rightmost ? const_iterator(_rightmost, rbtree_out_of_range_tag()) : const_iterator();
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+protected:
+	bstree()
+		: _root(nullptr), _leftmost(nullptr), _rightmost(nullptr), _size(0)
+	{ }
+
+	void touch(reference elem)
+	{
+		Algorithms::access(&_root, member_of(&elem, NodeMember));
+	}
+
+private:
+	typedef rbtree_key_compare<T, Compare> key_compare;
+
+	struct null_disposer {
+		void operator()(pointer) const { }
+	};
+
+	iterator insert(rbtree_node* node, rbtree_node* parent, rbtree_node** next)
+	{
+		if (!parent) {
+			_leftmost = node;
+			_rightmost = node;
+		} else if (next == &parent->left) {
+			if (parent == _leftmost)
+				_leftmost = node;
+		} else {
+			if (parent == _rightmost)
+				_rightmost = node;
+		}
+
+		Algorithms::insert(&_root, node, parent, next);
+		++_size;
+
+		return iterator(node);
+	}
+
+	iterator access(rbtree_node* node)
+	{
+		if (node)
+			Algorithms::access(&_root, node);
+
+		return make_iterator<iterator>(node);
+	}
+
+	//
+	// Matching node, if any, and the last node visited
+	//
+	template<class Key>
+	rbtree_node* find_impl(Key const& key, rbtree_node*& last) const
+	{
+		rbtree_node* next = _root;
+		Compare      cmp;
+
+		last = nullptr;
+		while (next) {
+			T const& elem = *parent_of(next, NodeMember);
+
+			last = next;
+			if (key_compare::key_less(cmp, key, elem))
+				next = next->left;
+			else if (key_compare::elem_less(cmp, elem, key))
+				next = next->right;
+			else
+				return next;
+		}
+
+		return nullptr;
+	}
+
+	//
+	// First node not ordered before key or, with Upper, after it
+	//
+	template<bool Upper, class Key>
+	rbtree_node* bound_impl(Key const& key) const
+	{
+		rbtree_node* next  = _root;
+		rbtree_node* bound = nullptr;
+		Compare      cmp;
+
+		while (next) {
+			T const& elem = *parent_of(next, NodeMember);
+
+			if (Upper ? key_compare::key_less(cmp, key, elem) : !key_compare::elem_less(cmp, elem, key)) {
+				bound = next;
+				next = next->left;
+			} else {
+				next = next->right;
+			}
+		}
+
+		return bound;
+	}
+
+	template<class Iterator>
+	Iterator make_iterator(rbtree_node* node) const
+	{
+		if (node)
+			return Iterator(node);
+
+		return _rightmost ? Iterator(_rightmost, rbtree_out_of_range_tag()) : Iterator();
+	}
+
+private:
+	rbtree_node* _root;
+	rbtree_node* _leftmost;
+	rbtree_node* _rightmost;
+	size_t       _size;
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_BSTREE__HPP_ */
@@ -0,0 +1,773 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_BTREE__HPP_
+#define UL_BTREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/debug.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#	include <nmmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+template<class Key, uint Order>
+struct btree_node {
+	uint count;
+	Key  keys[Order];
+};
+
+template<class T, class Key, uint Order>
+struct btree_leaf : btree_node<Key, Order> {
+	btree_leaf* prev;
+	btree_leaf* next;
+	T*          values[Order];
+};
+
+//
+// Inner nodes hold count separators and count + 1 children, the keys found
+// under children[i] are ordered before keys[i] and those under
+// children[i + 1] are not
+//
+template<class Key, uint Order>
+struct btree_inner : btree_node<Key, Order> {
+	btree_node<Key, Order>* children[Order + 1];
+};
+
+//
+// In-node search, position<false> is the number of keys ordered before key
+// and position<true> the number of keys not ordered after it
+//
+template<class Key, class Compare>
+struct btree_bsearch {
+	template<bool Upper>
+	static uint position(Key const* keys, uint count, Key const& key)
+	{
+		Compare cmp;
+
+		if (Upper)
+			return std::upper_bound(keys, keys + count, key, cmp) - keys;
+		else
+			return std::lower_bound(keys, keys + count, key, cmp) - keys;
+	}
+};
+
+//
+// Integer keys are scanned whole, without branches, which beats a binary
+// search at these node sizes and maps onto SIMD compares
+//
+template<class Key, uint Size>
+struct btree_scan {
+	template<bool Upper>
+	static uint position(Key const* keys, uint count, Key const& key)
+	{
+		uint n = 0;
+
+		for (uint i = 0; i < count; ++i)
+			n += Upper ? !(key < keys[i]) : keys[i] < key;
+
+		return n;
+	}
+};
+
+template<class Key>
+struct btree_scan<Key, 0> : btree_bsearch<Key, std::less<Key> > { };
+
+static const uchar k_btree_popcount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+#if defined(__SSE2__)
+template<class Key>
+struct btree_scan<Key, 4> {
+	//
+	// Reads up to the next multiple of 4 keys, the node key arrays are
+	// sized for it, and masks out the lanes past count
+	//
+	template<bool Upper>
+	static uint position(Key const* keys, uint count, Key const& key)
+	{
+		const sint32  bias = boost::is_signed<Key>::value ? 0 : sint32(0x80000000u);
+		const __m128i b    = _mm_set1_epi32(bias);
+		const __m128i k    = _mm_set1_epi32(sint32(key) ^ bias);
+		uint          n    = 0;
+
+		for (uint i = 0; i < count; i += 4) {
+			__m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i)), b);
+			__m128i m = Upper ? _mm_cmpgt_epi32(v, k) : _mm_cmpgt_epi32(k, v);
+			uint    r = _mm_movemask_ps(_mm_castsi128_ps(m));
+
+			if (count - i < 4)
+				r &= (1u << (count - i)) - 1;
+			n += k_btree_popcount[r];
+		}
+
+		return Upper ? count - n : n;
+	}
+};
+#endif
+
+#if defined(__SSE4_2__)
+template<class Key>
+struct btree_scan<Key, 8> {
+	template<bool Upper>
+	static uint position(Key const* keys, uint count, Key const& key)
+	{
+		const sint64  bias = boost::is_signed<Key>::value ? 0 : sint64(0x8000000000000000ull);
+		const __m128i b    = _mm_set1_epi64x(bias);
+		const __m128i k    = _mm_set1_epi64x(sint64(key) ^ bias);
+		uint          n    = 0;
+
+		for (uint i = 0; i < count; i += 2) {
+			__m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i)), b);
+			__m128i m = Upper ? _mm_cmpgt_epi64(v, k) : _mm_cmpgt_epi64(k, v);
+			uint    r = _mm_movemask_pd(_mm_castsi128_pd(m));
+
+			if (count - i < 2)
+				r &= 1;
+			n += k_btree_popcount[r];
+		}
+
+		return Upper ? count - n : n;
+	}
+};
+#endif
+
+template<class Key, class Compare>
+struct btree_search : btree_bsearch<Key, Compare> { };
+
+template<class Key>
+struct btree_search<Key, std::less<Key> >
+	: btree_scan<Key, boost::is_integral<Key>::value ? sizeof(Key) : 0> { };
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, class Key, uint Order>
+class btree_iterator
+	: public boost::iterator_facade<btree_iterator<T, Key, Order>, T, boost::bidirectional_traversal_tag> {
+
+	friend class boost::iterator_core_access;
+	template<class, class, class, class, uint> friend class btree;
+
+	typedef detail::btree_leaf<typename boost::remove_const<T>::type, Key, Order> leaf;
+
+public:
+	btree_iterator()
+		: _leaf(nullptr), _pos(0)
+	{ }
+
+	btree_iterator(leaf* l, uint pos)
+		: _leaf(l), _pos(pos)
+	{ }
+
+	Key const& key() const { return _leaf->keys[_pos]; }
+
+private:
+	//
+	// The end iterator is one past the last slot of the last leaf
+	//
+	void increment()
+	{
+		if (++_pos == _leaf->count && _leaf->next) {
+			_leaf = _leaf->next;
+			_pos = 0;
+		}
+	}
+
+	void decrement()
+	{
+		if (!_pos) {
+			_leaf = _leaf->prev;
+			_pos = _leaf->count;
+		}
+		--_pos;
+	}
+
+	bool equal(btree_iterator const& other) const { return _leaf == other._leaf && _pos == other._pos; }
+
+	T& dereference() const { return *_leaf->values[_pos]; }
+
+	leaf* _leaf;
+	uint  _pos;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief B+tree of element pointers ordered by the key \a GetKey extracts
+ *        from them, with up to \a Order keys per node.
+ *
+ * Elements are not owned, only the nodes are allocated by the tree. Keys are
+ * kept next to each other in the nodes, so a lookup takes one or two cache
+ * misses per level instead of one per comparison, and integer keys compared
+ * with std::less are searched with SIMD compares. Any insertion or removal
+ * invalidates all iterators.
+ */
+template<class T, class Key, class GetKey, class Compare = std::less<Key>, uint Order = 32>
+class btree {
+	btree(const btree&);
+	btree& operator=(const btree&);
+
+	static_assert(Order >= 8 && Order % 8 == 0, "btree order must be a multiple of 8");
+
+	typedef detail::btree_node<Key, Order>     node;
+	typedef detail::btree_leaf<T, Key, Order>  leaf;
+	typedef detail::btree_inner<Key, Order>    inner;
+	typedef detail::btree_search<Key, Compare> search;
+
+public:
+	typedef Key                                   key_type;
+	typedef T*                                    pointer;
+	typedef T&                                    reference;
+	typedef T const&                              const_reference;
+	typedef btree_iterator<T, Key, Order>         iterator;
+	typedef btree_iterator<T const, Key, Order>   const_iterator;
+	typedef std::reverse_iterator<iterator>       reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	btree()
+		: _root(nullptr), _head(nullptr), _tail(nullptr), _depth(0), _size(0)
+	{ }
+
+	~btree()
+	{
+		clear();
+	}
+
+	/**
+	 * May throw std::bad_alloc, in which case the tree is left unchanged.
+	 */
+	std::pair<iterator, bool> insert_unique(reference elem)
+	{
+		Key    key = GetKey()(elem);
+		inner* path[k_max_depth];
+		uint   slots[k_max_depth];
+
+		if (!_root) {
+			leaf* l = new leaf();
+
+			_root = _head = _tail = l;
+		}
+
+		leaf* l   = descend(key, path, slots);
+		uint  pos = search::template position<false>(l->keys, l->count, key);
+
+		if (pos < l->count && !Compare()(key, l->keys[pos]))
+			return std::pair<iterator, bool>(iterator(l, pos), false);
+
+		iterator i = insert_at(l, pos, key, &elem, path, slots);
+
+		++_size;
+		return std::pair<iterator, bool>(i, true);
+	}
+
+	iterator find(Key const& key)
+	{
+		return find_impl<iterator>(key);
+	}
+
+	const_iterator find(Key const& key) const
+	{
+		return find_impl<const_iterator>(key);
+	}
+
+	iterator lower_bound(Key const& key)
+	{
+		return bound_impl<iterator, false>(key);
+	}
+
+	const_iterator lower_bound(Key const& key) const
+	{
+		return bound_impl<const_iterator, false>(key);
+	}
+
+	iterator upper_bound(Key const& key)
+	{
+		return bound_impl<iterator, true>(key);
+	}
+
+	const_iterator upper_bound(Key const& key) const
+	{
+		return bound_impl<const_iterator, true>(key);
+	}
+
+	size_t count(Key const& key) const
+	{
+		return find(key) != end();
+	}
+
+	void remove(iterator i)
+	{
+		Key    key = i.key();
+		inner* path[k_max_depth];
+		uint   slots[k_max_depth];
+
+		leaf* l = descend(key, path, slots);
+		UL_ASSERT(l == i._leaf);
+
+		erase(l, i._pos, path, slots);
+	}
+
+	bool remove(Key const& key)
+	{
+		inner* path[k_max_depth];
+		uint   slots[k_max_depth];
+
+		leaf* l = descend(key, path, slots);
+		if (!l)
+			return false;
+
+		uint pos = search::template position<false>(l->keys, l->count, key);
+		if (pos == l->count || Compare()(key, l->keys[pos]))
+			return false;
+
+		erase(l, pos, path, slots);
+		return true;
+	}
+
+	/**
+	 * Free every node, the elements are left untouched.
+	 */
+	void clear()
+	{
+		if (_root)
+			dispose(_root, _depth);
+
+		_root = _head = _tail = nullptr;
+		_depth = 0;
+		_size = 0;
+	}
+
+	bool empty() const
+	{
+		return !_size;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	void swap(btree& other)
+	{
+		std::swap(_root, other._root);
+		std::swap(_head, other._head);
+		std::swap(_tail, other._tail);
+		std::swap(_depth, other._depth);
+		std::swap(_size, other._size);
+	}
+
+	iterator begin()
+	{
+		return iterator(_head, 0);
+	}
+
+	iterator end()
+	{
+		return end_impl<iterator>();
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(_head, 0);
+	}
+
+	const_iterator end() const
+	{
+		return end_impl<const_iterator>();
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+private:
+	//
+	// Nodes other than the root are kept at least half full, so a tree of
+	// 2^64 elements is less than 32 levels deep
+	//
+	static const uint k_min       = Order / 2;
+	static const uint k_max_depth = 32;
+
+	//
+	// Leaf where key belongs, recording the inner nodes and child slots
+	// taken on the way when path is given
+	//
+	leaf* descend(Key const& key, inner** path, uint* slots) const
+	{
+		node* n = _root;
+
+		for (uint d = 0; d < _depth; ++d) {
+			inner* in = static_cast<inner*>(n);
+			uint   s  = search::template position<true>(in->keys, in->count, key);
+
+			if (path) {
+				path[d] = in;
+				slots[d] = s;
+			}
+			n = in->children[s];
+		}
+
+		return static_cast<leaf*>(n);
+	}
+
+	template<class Iterator>
+	Iterator end_impl() const
+	{
+		return _tail ? Iterator(_tail, _tail->count) : Iterator();
+	}
+
+	template<class Iterator>
+	Iterator find_impl(Key const& key) const
+	{
+		leaf* l = descend(key, nullptr, nullptr);
+		if (!l)
+			return Iterator();
+
+		uint pos = search::template position<false>(l->keys, l->count, key);
+		if (pos == l->count || Compare()(key, l->keys[pos]))
+			return end_impl<Iterator>();
+
+		return Iterator(l, pos);
+	}
+
+	template<class Iterator, bool Upper>
+	Iterator bound_impl(Key const& key) const
+	{
+		leaf* l = descend(key, nullptr, nullptr);
+		if (!l)
+			return Iterator();
+
+		uint pos = search::template position<Upper>(l->keys, l->count, key);
+		if (pos == l->count && l->next)
+			return Iterator(l->next, 0);
+
+		return Iterator(l, pos);
+	}
+
+	iterator insert_at(leaf* l, uint pos, Key const& key, T* value, inner** path, uint* slots)
+	{
+		if (l->count < Order) {
+			std::copy_backward(l->keys + pos, l->keys + l->count, l->keys + l->count + 1);
+			std::copy_backward(l->values + pos, l->values + l->count, l->values + l->count + 1);
+			l->keys[pos] = key;
+			l->values[pos] = value;
+			++l->count;
+			return iterator(l, pos);
+		}
+
+		//
+		// Allocate every node the splits need before touching the tree, so
+		// that a failed allocation leaves it unchanged
+		//
+		uint   level = _depth;
+		uint   count = 0;
+		inner* spare[k_max_depth + 1];
+
+		while (level && path[level - 1]->count == Order)
+			--level;
+
+		leaf* r = new leaf();
+		try {
+			for (; count < _depth - level + !level; ++count)
+				spare[count] = new inner();
+		} catch (...) {
+			while (count)
+				delete spare[--count];
+			delete r;
+			throw;
+		}
+
+		//
+		// Split the leaf, the lower (Order + 1) / 2 elements stay in place
+		//
+		const uint split = (Order + 1) / 2;
+		Key        keys[Order + 1];
+		T*         values[Order + 1];
+
+		std::copy(l->keys, l->keys + pos, keys);
+		std::copy(l->values, l->values + pos, values);
+		keys[pos] = key;
+		values[pos] = value;
+		std::copy(l->keys + pos, l->keys + Order, keys + pos + 1);
+		std::copy(l->values + pos, l->values + Order, values + pos + 1);
+
+		std::copy(keys, keys + split, l->keys);
+		std::copy(values, values + split, l->values);
+		std::copy(keys + split, keys + Order + 1, r->keys);
+		std::copy(values + split, values + Order + 1, r->values);
+		l->count = split;
+		r->count = Order + 1 - split;
+
+		r->prev = l;
+		r->next = l->next;
+		if (l->next)
+			l->next->prev = r;
+		else
+			_tail = r;
+		l->next = r;
+
+		iterator result = pos < split ? iterator(l, pos) : iterator(r, pos - split);
+
+		//
+		// Hand the separator and the new node up until a parent has room
+		//
+		Key   separator = r->keys[0];
+		node* child     = r;
+
+		for (uint d = _depth; d--;) {
+			inner* p = path[d];
+			uint   s = slots[d];
+
+			if (p->count < Order) {
+				std::copy_backward(p->keys + s, p->keys + p->count, p->keys + p->count + 1);
+				std::copy_backward(p->children + s + 1, p->children + p->count + 1, p->children + p->count + 2);
+				p->keys[s] = separator;
+				p->children[s + 1] = child;
+				++p->count;
+				return result;
+			}
+
+			const uint mid = Order / 2;
+			Key        ikeys[Order + 1];
+			node*      ichildren[Order + 2];
+			inner*     q = spare[--count];
+
+			std::copy(p->keys, p->keys + s, ikeys);
+			ikeys[s] = separator;
+			std::copy(p->keys + s, p->keys + Order, ikeys + s + 1);
+			std::copy(p->children, p->children + s + 1, ichildren);
+			ichildren[s + 1] = child;
+			std::copy(p->children + s + 1, p->children + Order + 1, ichildren + s + 2);
+
+			std::copy(ikeys, ikeys + mid, p->keys);
+			std::copy(ichildren, ichildren + mid + 1, p->children);
+			std::copy(ikeys + mid + 1, ikeys + Order + 1, q->keys);
+			std::copy(ichildren + mid + 1, ichildren + Order + 2, q->children);
+			p->count = mid;
+			q->count = Order - mid;
+
+			separator = ikeys[mid];
+			child = q;
+		}
+
+		//
+		// The root was split, grow the tree by one level
+		//
+		inner* root = spare[--count];
+
+		UL_ASSERT(!count);
+		root->count = 1;
+		root->keys[0] = separator;
+		root->children[0] = _root;
+		root->children[1] = child;
+		_root = root;
+		++_depth;
+
+		return result;
+	}
+
+	void erase(leaf* l, uint pos, inner** path, uint* slots)
+	{
+		std::copy(l->keys + pos + 1, l->keys + l->count, l->keys + pos);
+		std::copy(l->values + pos + 1, l->values + l->count, l->values + pos);
+		--l->count;
+		--_size;
+
+		if (!_depth) {
+			if (!l->count) {
+				delete l;
+				_root = _head = _tail = nullptr;
+			}
+			return;
+		}
+
+		if (l->count >= k_min)
+			return;
+
+		rebalance(l, path[_depth - 1], slots[_depth - 1]);
+		for (uint d = _depth - 1; d > 0 && path[d]->count < k_min; --d)
+			rebalance(path[d], path[d - 1], slots[d - 1]);
+
+		//
+		// An inner root left with a single child is dropped
+		//
+		if (!_root->count) {
+			inner* root = static_cast<inner*>(_root);
+
+			_root = root->children[0];
+			--_depth;
+			delete root;
+		}
+	}
+
+	//
+	// Refill the leaf at slot s of p from a sibling, or merge it with one
+	//
+	void rebalance(leaf* l, inner* p, uint s)
+	{
+		leaf* left  = s > 0 ? static_cast<leaf*>(p->children[s - 1]) : nullptr;
+		leaf* right = s < p->count ? static_cast<leaf*>(p->children[s + 1]) : nullptr;
+
+		if (left && left->count > k_min) {
+			std::copy_backward(l->keys, l->keys + l->count, l->keys + l->count + 1);
+			std::copy_backward(l->values, l->values + l->count, l->values + l->count + 1);
+			--left->count;
+			l->keys[0] = left->keys[left->count];
+			l->values[0] = left->values[left->count];
+			++l->count;
+			p->keys[s - 1] = l->keys[0];
+		} else if (right && right->count > k_min) {
+			l->keys[l->count] = right->keys[0];
+			l->values[l->count] = right->values[0];
+			++l->count;
+			std::copy(right->keys + 1, right->keys + right->count, right->keys);
+			std::copy(right->values + 1, right->values + right->count, right->values);
+			--right->count;
+			p->keys[s] = right->keys[0];
+		} else if (left) {
+			merge(left, l, p, s - 1);
+		} else {
+			merge(l, right, p, s);
+		}
+	}
+
+	void rebalance(inner* n, inner* p, uint s)
+	{
+		inner* left  = s > 0 ? static_cast<inner*>(p->children[s - 1]) : nullptr;
+		inner* right = s < p->count ? static_cast<inner*>(p->children[s + 1]) : nullptr;
+
+		if (left && left->count > k_min) {
+			std::copy_backward(n->keys, n->keys + n->count, n->keys + n->count + 1);
+			std::copy_backward(n->children, n->children + n->count + 1, n->children + n->count + 2);
+			n->keys[0] = p->keys[s - 1];
+			n->children[0] = left->children[left->count];
+			++n->count;
+			--left->count;
+			p->keys[s - 1] = left->keys[left->count];
+		} else if (right && right->count > k_min) {
+			n->keys[n->count] = p->keys[s];
+			n->children[n->count + 1] = right->children[0];
+			++n->count;
+			p->keys[s] = right->keys[0];
+			std::copy(right->keys + 1, right->keys + right->count, right->keys);
+			std::copy(right->children + 1, right->children + right->count + 1, right->children);
+			--right->count;
+		} else if (left) {
+			merge(left, n, p, s - 1);
+		} else {
+			merge(n, right, p, s);
+		}
+	}
+
+	//
+	// Fold the node at slot s + 1 of p into the one at slot s
+	//
+	void merge(leaf* a, leaf* b, inner* p, uint s)
+	{
+		std::copy(b->keys, b->keys + b->count, a->keys + a->count);
+		std::copy(b->values, b->values + b->count, a->values + a->count);
+		a->count += b->count;
+
+		a->next = b->next;
+		if (b->next)
+			b->next->prev = a;
+		else
+			_tail = a;
+
+		delete b;
+		drop(p, s);
+	}
+
+	void merge(inner* a, inner* b, inner* p, uint s)
+	{
+		a->keys[a->count] = p->keys[s];
+		std::copy(b->keys, b->keys + b->count, a->keys + a->count + 1);
+		std::copy(b->children, b->children + b->count + 1, a->children + a->count + 1);
+		a->count += b->count + 1;
+
+		delete b;
+		drop(p, s);
+	}
+
+	//
+	// Remove separator s and the child to its right from p
+	//
+	static void drop(inner* p, uint s)
+	{
+		std::copy(p->keys + s + 1, p->keys + p->count, p->keys + s);
+		std::copy(p->children + s + 2, p->children + p->count + 1, p->children + s + 1);
+		--p->count;
+	}
+
+	static void dispose(node* n, uint depth)
+	{
+		if (!depth) {
+			delete static_cast<leaf*>(n);
+			return;
+		}
+
+		inner* in = static_cast<inner*>(n);
+		for (uint i = 0; i <= in->count; ++i)
+			dispose(in->children[i], depth - 1);
+		delete in;
+	}
+
+private:
+	node*  _root;
+	leaf*  _head;
+	leaf*  _tail;
+	uint   _depth;
+	size_t _size;
+};
+
+template<class T, class Key, class GetKey, class Compare, uint Order>
+inline void swap(btree<T, Key, GetKey, Compare, Order>& rhs, btree<T, Key, GetKey, Compare, Order>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_BTREE__HPP_ */
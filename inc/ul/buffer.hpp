@@ -27,9 +27,9 @@ class buffer : boost::noncopyable {
 	UL_STATIC_ASSERT(boost::is_integral<T>::value, "T must be an integral type");
 
 public:
-	buffer()           : _ptr(nullptr) { }
-	buffer(size_t len) : _ptr(nullptr) { size(len); }
-	~buffer()                          { std::free(_ptr); }
+	buffer()           : _ptr(nullptr), _len(0) { }
+	buffer(size_t len) : _ptr(nullptr), _len(0) { size(len); }
+	~buffer()                                   { std::free(_ptr); }
 
 	void size(size_t len)
 	{
@@ -0,0 +1,40 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_EXECUTOR__HPP_
+#define UL_EXECUTOR__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Fork-join executor that runs both branches on the calling thread.
+ *
+ * Executors provide fork(f, g), which runs both callables, possibly in
+ * parallel, and returns once both are done.
+ */
+struct sequential_executor {
+	template<class F, class G>
+	void fork(F const& f, G const& g)
+	{
+		f();
+		g();
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_EXECUTOR__HPP_ */
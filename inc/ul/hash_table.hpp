@@ -0,0 +1,459 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_HASH_TABLE__HPP_
+#define UL_HASH_TABLE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Hash table hook, the link to the next element of the bucket and the
+ *        hash of the element.
+ */
+struct hash_table_node {
+	hash_table_node()
+		: next(nullptr), hash(0)
+	{ }
+
+	hash_table_node* next;
+	size_t           hash;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+//
+// Bucket array, indexed by the top bits of the hash times the golden ratio
+//
+struct hash_table_array {
+	hash_table_array()
+		: buckets(nullptr), count(0), shift(0)
+	{ }
+
+	size_t index(size_t hash) const
+	{
+		return static_cast<size_t>((uint64(hash) * 0x9e3779b97f4a7c15ULL) >> shift);
+	}
+
+	hash_table_node** buckets;
+	size_t            count;
+	uint              shift;
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, hash_table_node T::* NodeMember>
+class hash_table_iterator
+	: public boost::iterator_facade<hash_table_iterator<T, NodeMember>, T, boost::forward_traversal_tag> {
+
+	friend class boost::iterator_core_access;
+
+public:
+	hash_table_iterator()
+		: _arrays(nullptr), _which(0), _bucket(0), _node(nullptr)
+	{ }
+
+	//
+	// Elements of the array being rehashed come first, the buckets already
+	// moved from it are empty
+	//
+	hash_table_iterator(detail::hash_table_array const* arrays, uint which, size_t bucket, hash_table_node* node)
+		: _arrays(arrays), _which(which), _bucket(bucket), _node(node)
+	{
+		if (!_node && _arrays)
+			seek();
+	}
+
+private:
+	void increment()
+	{
+		_node = _node->next;
+		if (!_node) {
+			++_bucket;
+			seek();
+		}
+	}
+
+	void seek()
+	{
+		for (;;) {
+			detail::hash_table_array const& a = _arrays[_which];
+
+			for (; _bucket < a.count; ++_bucket) {
+				if (a.buckets[_bucket]) {
+					_node = a.buckets[_bucket];
+					return;
+				}
+			}
+
+			if (!_which)
+				return;
+
+			_which = 0;
+			_bucket = 0;
+		}
+	}
+
+	bool equal(hash_table_iterator const& other) const { return _node == other._node; }
+
+	T& dereference() const { return *parent_of(_node, NodeMember); }
+
+	detail::hash_table_array const* _arrays;
+	uint                            _which;
+	size_t                          _bucket;
+	hash_table_node*                _node;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive hash table, chaining elements through their hook.
+ *
+ * The table doubles its buckets once it holds as many elements. Instead of
+ * moving every element at once, the old buckets are kept around and a few
+ * of them are moved by each insert and remove that follows, while lookups
+ * search both arrays. No single operation pays for a whole rehash.
+ *
+ * Lookups by keys other than T need Hash and Eq to handle them, hashing
+ * them like the matching elements. Inserting and removing elements
+ * invalidates iterators.
+ */
+template<class T, hash_table_node T::* NodeMember, class Hash = std::hash<T>, class Eq = std::equal_to<T> >
+class hash_table {
+	hash_table(const hash_table&);
+	hash_table& operator=(const hash_table&);
+
+	static const size_t k_min_buckets  = 16;
+	static const uint   k_rehash_steps = 4;
+
+public:
+	typedef T*                                        pointer;
+	typedef T&                                        reference;
+	typedef T const&                                  const_reference;
+	typedef hash_table_iterator<T, NodeMember>        iterator;
+	typedef hash_table_iterator<T const, NodeMember>  const_iterator;
+
+	hash_table()
+		: _size(0), _rehash(0)
+	{ }
+
+	~hash_table()
+	{
+		delete[] _arrays[0].buckets;
+		delete[] _arrays[1].buckets;
+	}
+
+	/**
+	 * May throw std::bad_alloc when the table grows, in which case it is
+	 * left unchanged.
+	 */
+	std::pair<iterator, bool> insert_unique(reference elem)
+	{
+		size_t           hash = Hash()(elem);
+		hash_table_node* node = find_node(elem, hash);
+
+		if (node)
+			return std::pair<iterator, bool>(make_iterator<iterator>(node), false);
+
+		return std::pair<iterator, bool>(link(elem, hash), true);
+	}
+
+	iterator insert_equal(reference elem)
+	{
+		return link(elem, Hash()(elem));
+	}
+
+	template<class Key>
+	iterator find(Key const& key)
+	{
+		return make_iterator<iterator>(find_node(key, Hash()(key)));
+	}
+
+	template<class Key>
+	const_iterator find(Key const& key) const
+	{
+		return make_iterator<const_iterator>(find_node(key, Hash()(key)));
+	}
+
+	template<class Key>
+	size_t count(Key const& key) const
+	{
+		size_t hash = Hash()(key);
+		size_t n    = 0;
+		Eq     eq;
+
+		for (uint i = 0; i < 2; ++i) {
+			for (hash_table_node* node = bucket_of(i, hash); node; node = node->next) {
+				if (node->hash == hash && eq(key, *parent_of(node, NodeMember)))
+					++n;
+			}
+		}
+
+		return n;
+	}
+
+	void remove(iterator i)
+	{
+		remove(*i);
+	}
+
+	void remove(reference elem)
+	{
+		hash_table_node*  node = member_of(&elem, NodeMember);
+		hash_table_node** link = &bucket_link(node->hash);
+
+		while (*link != node)
+			link = &(*link)->next;
+
+		*link = node->next;
+		node->next = nullptr;
+		--_size;
+		rehash_step();
+	}
+
+	template<class Key>
+	bool remove(Key const& key)
+	{
+		hash_table_node* node = find_node(key, Hash()(key));
+
+		if (!node)
+			return false;
+
+		remove(*parent_of(node, NodeMember));
+		return true;
+	}
+
+	void clear()
+	{
+		clear_and_dispose(null_disposer());
+	}
+
+	/**
+	 * Unlink every element, handing each one to \a disposer once unlinked.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		for (uint i = 0; i < 2; ++i) {
+			detail::hash_table_array& a = _arrays[i];
+
+			for (size_t b = 0; b < a.count; ++b) {
+				hash_table_node* node = a.buckets[b];
+
+				a.buckets[b] = nullptr;
+				while (node) {
+					hash_table_node* next = node->next;
+
+					node->next = nullptr;
+					disposer(parent_of(node, NodeMember));
+					node = next;
+				}
+			}
+		}
+
+		delete[] _arrays[1].buckets;
+		_arrays[1] = detail::hash_table_array();
+		_size = 0;
+		_rehash = 0;
+	}
+
+	bool empty() const
+	{
+		return !_size;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	size_t bucket_count() const
+	{
+		return _arrays[0].count;
+	}
+
+	void swap(hash_table& other)
+	{
+		std::swap(_arrays[0], other._arrays[0]);
+		std::swap(_arrays[1], other._arrays[1]);
+		std::swap(_size, other._size);
+		std::swap(_rehash, other._rehash);
+	}
+
+	iterator begin()
+	{
+		return iterator(_arrays, 1, 0, nullptr);
+	}
+
+	iterator end()
+	{
+		return iterator();
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(_arrays, 1, 0, nullptr);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator();
+	}
+
+private:
+	struct null_disposer {
+		void operator()(pointer) const { }
+	};
+
+	//
+	// Elements still in the array being rehashed are in buckets not yet moved
+	//
+	uint which_of(size_t hash) const
+	{
+		return _arrays[1].buckets && _arrays[1].index(hash) >= _rehash ? 1 : 0;
+	}
+
+	hash_table_node*& bucket_link(size_t hash)
+	{
+		detail::hash_table_array& a = _arrays[which_of(hash)];
+
+		return a.buckets[a.index(hash)];
+	}
+
+	hash_table_node* bucket_of(uint which, size_t hash) const
+	{
+		detail::hash_table_array const& a = _arrays[which];
+
+		return a.count ? a.buckets[a.index(hash)] : nullptr;
+	}
+
+	template<class Key>
+	hash_table_node* find_node(Key const& key, size_t hash) const
+	{
+		Eq eq;
+
+		if (!_size)
+			return nullptr;
+
+		for (hash_table_node* node = bucket_of(which_of(hash), hash); node; node = node->next) {
+			if (node->hash == hash && eq(key, *parent_of(node, NodeMember)))
+				return node;
+		}
+
+		return nullptr;
+	}
+
+	template<class Iterator>
+	Iterator make_iterator(hash_table_node* node) const
+	{
+		if (!node)
+			return Iterator();
+
+		uint which = which_of(node->hash);
+
+		return Iterator(_arrays, which, _arrays[which].index(node->hash), node);
+	}
+
+	iterator link(reference elem, size_t hash)
+	{
+		hash_table_node* node = member_of(&elem, NodeMember);
+
+		if (_size >= _arrays[0].count)
+			grow();
+		rehash_step();
+
+		hash_table_node*& head = bucket_link(hash);
+
+		node->hash = hash;
+		node->next = head;
+		head = node;
+		++_size;
+
+		return make_iterator<iterator>(node);
+	}
+
+	//
+	// Start moving the elements to an array twice as large, after finishing
+	// any rehash still under way
+	//
+	void grow()
+	{
+		detail::hash_table_array a;
+
+		a.count = _arrays[0].count ? _arrays[0].count * 2 : k_min_buckets;
+		a.buckets = new hash_table_node*[a.count]();
+		a.shift = 64;
+		for (size_t n = a.count; n > 1; n >>= 1)
+			--a.shift;
+
+		while (_arrays[1].buckets)
+			rehash_step();
+
+		if (_arrays[0].buckets) {
+			_arrays[1] = _arrays[0];
+			_rehash = 0;
+		}
+		_arrays[0] = a;
+	}
+
+	void rehash_step()
+	{
+		detail::hash_table_array& old = _arrays[1];
+
+		if (!old.buckets)
+			return;
+
+		for (uint i = 0; i < k_rehash_steps && _rehash < old.count; ++i, ++_rehash) {
+			hash_table_node* node = old.buckets[_rehash];
+
+			old.buckets[_rehash] = nullptr;
+			while (node) {
+				hash_table_node*  next = node->next;
+				hash_table_node*& head = _arrays[0].buckets[_arrays[0].index(node->hash)];
+
+				node->next = head;
+				head = node;
+				node = next;
+			}
+		}
+
+		if (_rehash == old.count) {
+			delete[] old.buckets;
+			old = detail::hash_table_array();
+			_rehash = 0;
+		}
+	}
+
+private:
+	detail::hash_table_array _arrays[2];
+	size_t                   _size;
+	size_t                   _rehash;
+};
+
+template<class T, hash_table_node T::* NodeMember, class Hash, class Eq>
+inline void swap(hash_table<T, NodeMember, Hash, Eq>& rhs, hash_table<T, NodeMember, Hash, Eq>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_HASH_TABLE__HPP_ */
@@ -0,0 +1,457 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_INDEX_RBTREE__HPP_
+#define UL_INDEX_RBTREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/rbtree.hpp>
+#include <ul/rbtree_algorithms.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <iterator>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Red-black tree hook linking elements of a pool by their 32-bit
+ *        index, the color takes the top bit of the parent index.
+ */
+struct index_rbtree_node {
+	static const uint32 k_null = 0x7fffffff;
+
+	index_rbtree_node()
+		: _parent(k_null), left(k_null), right(k_null)
+	{ }
+
+	void parent(uint32 p)
+	{
+		_parent = (_parent & k_color_bit) | p;
+	}
+	uint32 parent() const
+	{
+		return _parent & ~k_color_bit;
+	}
+
+	void color(rbtree_node::color_type c)
+	{
+		_parent = (_parent & ~k_color_bit) | (c == rbtree_node::black ? k_color_bit : 0);
+	}
+	rbtree_node::color_type color() const
+	{
+		return (_parent & k_color_bit) ? rbtree_node::black : rbtree_node::red;
+	}
+
+private:
+	static const uint32 k_color_bit = 0x80000000;
+
+	uint32 _parent;
+
+public:
+	uint32 left;
+	uint32 right;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+template<class T, index_rbtree_node T::* NodeMember>
+struct index_rbtree_traits {
+	typedef uint32 node_ptr;
+
+	explicit index_rbtree_traits(T* p)
+		: pool(p)
+	{ }
+
+	static uint32 null() { return index_rbtree_node::k_null; }
+
+	index_rbtree_node& node(uint32 n) const { return pool[n].*NodeMember; }
+
+	uint32 parent(uint32 n) const          { return node(n).parent(); }
+	void   parent(uint32 n, uint32 p) const { node(n).parent(p); }
+	uint32 left(uint32 n) const            { return node(n).left; }
+	void   left(uint32 n, uint32 l) const  { node(n).left = l; }
+	uint32 right(uint32 n) const           { return node(n).right; }
+	void   right(uint32 n, uint32 r) const { node(n).right = r; }
+
+	rbtree_node::color_type color(uint32 n) const                            { return node(n).color(); }
+	void                    color(uint32 n, rbtree_node::color_type c) const { node(n).color(c); }
+
+	T* pool;
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, index_rbtree_node T::* NodeMember>
+class index_rbtree_iterator
+	: public boost::iterator_facade<index_rbtree_iterator<T, NodeMember>, T, boost::bidirectional_traversal_tag> {
+
+	friend class boost::iterator_core_access;
+
+	typedef typename boost::remove_const<T>::type                 element_type;
+	typedef detail::index_rbtree_traits<element_type, NodeMember> traits;
+	typedef rbtree_algorithms<traits>                             algorithms;
+
+	//
+	// As with rbtree_iterator, the end iterator is the last element tagged
+	// as out of range
+	//
+	static const uint32 k_out_of_range_bit = 0x80000000;
+
+public:
+	index_rbtree_iterator()
+		: _pool(nullptr), _index(index_rbtree_node::k_null)
+	{ }
+
+	index_rbtree_iterator(T* pool, uint32 index)
+		: _pool(const_cast<element_type*>(pool)), _index(index)
+	{ }
+
+	index_rbtree_iterator(T* pool, uint32 index, rbtree_out_of_range_tag)
+		: _pool(const_cast<element_type*>(pool)), _index(index | k_out_of_range_bit)
+	{ }
+
+	uint32 index() const { return _index & ~k_out_of_range_bit; }
+
+private:
+	void increment()
+	{
+		uint32 next = algorithms::next(traits(_pool), _index);
+
+		if (next != traits::null())
+			_index = next;
+		else
+			_index |= k_out_of_range_bit;
+	}
+
+	void decrement()
+	{
+		if (_index & k_out_of_range_bit) {
+			_index &= ~k_out_of_range_bit;
+			return;
+		}
+
+		uint32 prev = algorithms::prev(traits(_pool), _index);
+
+		if (prev != traits::null())
+			_index = prev;
+		else
+			_index |= k_out_of_range_bit;
+	}
+
+	bool equal(index_rbtree_iterator const& other) const { return _index == other._index; }
+
+	T& dereference() const { return _pool[_index]; }
+
+	element_type* _pool;
+	uint32        _index;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive red-black tree over the elements of a caller supplied
+ *        pool, linked by 32-bit indices into it.
+ *
+ * The hook takes 12 bytes instead of the 24 of rbtree_node on 64-bit
+ * targets. Every element linked into the tree must live in the pool, which
+ * holds at most 2^31 - 1 elements.
+ */
+template<class T, index_rbtree_node T::* NodeMember, class Compare = std::less<T> >
+class index_rbtree {
+	index_rbtree(const index_rbtree&);
+	index_rbtree& operator=(const index_rbtree&);
+
+	typedef detail::index_rbtree_traits<T, NodeMember> traits;
+	typedef rbtree_algorithms<traits>                  algorithms;
+	typedef detail::rbtree_key_compare<T, Compare>     key_compare;
+
+public:
+	typedef T*                                          pointer;
+	typedef T&                                          reference;
+	typedef T const&                                    const_reference;
+	typedef index_rbtree_iterator<T, NodeMember>        iterator;
+	typedef index_rbtree_iterator<T const, NodeMember>  const_iterator;
+	typedef std::reverse_iterator<iterator>             reverse_iterator;
+	typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+
+	explicit index_rbtree(T* pool)
+		: _pool(pool), _root(traits::null()), _leftmost(traits::null()), _rightmost(traits::null()), _size(0)
+	{ }
+
+	iterator insert_equal(reference elem)
+	{
+		uint32  node   = index_of(elem);
+		uint32  parent = traits::null();
+		bool    left   = false;
+		Compare cmp;
+
+		for (uint32 next = _root; next != traits::null();) {
+			parent = next;
+			left = cmp(elem, _pool[next]);
+			next = left ? (_pool[next].*NodeMember).left : (_pool[next].*NodeMember).right;
+		}
+
+		return link(node, parent, left);
+	}
+
+	std::pair<iterator, bool> insert_unique(reference elem)
+	{
+		uint32  node   = index_of(elem);
+		uint32  parent = traits::null();
+		bool    left   = false;
+		Compare cmp;
+
+		for (uint32 next = _root; next != traits::null();) {
+			parent = next;
+			left = cmp(elem, _pool[next]);
+			if (!left && !cmp(_pool[next], elem))
+				return std::pair<iterator, bool>(iterator(_pool, next), false);
+			next = left ? (_pool[next].*NodeMember).left : (_pool[next].*NodeMember).right;
+		}
+
+		return std::pair<iterator, bool>(link(node, parent, left), true);
+	}
+
+	template<class Key>
+	iterator find(Key const& key)
+	{
+		return make_iterator<iterator>(find_impl(key));
+	}
+
+	template<class Key>
+	const_iterator find(Key const& key) const
+	{
+		return make_iterator<const_iterator>(find_impl(key));
+	}
+
+	template<class Key>
+	iterator lower_bound(Key const& key)
+	{
+		return make_iterator<iterator>(bound_impl<false>(key));
+	}
+
+	template<class Key>
+	const_iterator lower_bound(Key const& key) const
+	{
+		return make_iterator<const_iterator>(bound_impl<false>(key));
+	}
+
+	template<class Key>
+	iterator upper_bound(Key const& key)
+	{
+		return make_iterator<iterator>(bound_impl<true>(key));
+	}
+
+	template<class Key>
+	const_iterator upper_bound(Key const& key) const
+	{
+		return make_iterator<const_iterator>(bound_impl<true>(key));
+	}
+
+	void remove(iterator i)
+	{
+		remove(*i);
+	}
+
+	void remove(reference elem)
+	{
+		uint32 node = index_of(elem);
+
+		if (node == _leftmost)
+			_leftmost = algorithms::next(traits(_pool), node);
+		if (node == _rightmost)
+			_rightmost = algorithms::prev(traits(_pool), node);
+
+		algorithms::erase(traits(_pool), _root, node);
+		--_size;
+	}
+
+	template<class Key>
+	bool remove(Key const& key)
+	{
+		uint32 node = find_impl(key);
+		if (node == traits::null())
+			return false;
+
+		remove(_pool[node]);
+		return true;
+	}
+
+	bool empty() const
+	{
+		return _root == traits::null();
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	/**
+	 * Position of \a elem in the pool, which is how the tree links it.
+	 */
+	uint32 index_of(const_reference elem) const
+	{
+		return static_cast<uint32>(&elem - _pool);
+	}
+
+	void swap(index_rbtree& other)
+	{
+		std::swap(_pool, other._pool);
+		std::swap(_root, other._root);
+		std::swap(_leftmost, other._leftmost);
+		std::swap(_rightmost, other._rightmost);
+		std::swap(_size, other._size);
+	}
+
+	//
+	// The first and last elements are cached, so that iterating takes O(1)
+	// amortized time per step as with rbtree
+	//
+	iterator begin()
+	{
+		return empty() ? end() : iterator(_pool, _leftmost);
+	}
+
+	iterator end()
+	{
+		return make_iterator<iterator>(traits::null());
+	}
+
+	const_iterator begin() const
+	{
+		return empty() ? end() : const_iterator(_pool, _leftmost);
+	}
+
+	const_iterator end() const
+	{
+		return make_iterator<const_iterator>(traits::null());
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+private:
+	template<class Key>
+	uint32 find_impl(Key const& key) const
+	{
+		uint32  next = _root;
+		Compare cmp;
+
+		while (next != traits::null()) {
+			index_rbtree_node const& node = _pool[next].*NodeMember;
+
+			if (key_compare::key_less(cmp, key, _pool[next]))
+				next = node.left;
+			else if (key_compare::elem_less(cmp, _pool[next], key))
+				next = node.right;
+			else
+				return next;
+		}
+
+		return traits::null();
+	}
+
+	//
+	// First element not ordered before key or, with Upper, after it
+	//
+	template<bool Upper, class Key>
+	uint32 bound_impl(Key const& key) const
+	{
+		uint32  next  = _root;
+		uint32  bound = traits::null();
+		Compare cmp;
+
+		while (next != traits::null()) {
+			index_rbtree_node const& node = _pool[next].*NodeMember;
+
+			if (Upper ? key_compare::key_less(cmp, key, _pool[next])
+			          : !key_compare::elem_less(cmp, _pool[next], key)) {
+				bound = next;
+				next = node.left;
+			} else {
+				next = node.right;
+			}
+		}
+
+		return bound;
+	}
+
+	template<class Iterator>
+	Iterator make_iterator(uint32 node) const
+	{
+		if (node != traits::null())
+			return Iterator(_pool, node);
+		if (empty())
+			return Iterator(_pool, traits::null());
+
+		return Iterator(_pool, _rightmost, rbtree_out_of_range_tag());
+	}
+
+	iterator link(uint32 node, uint32 parent, bool left)
+	{
+		if (parent == traits::null()) {
+			_leftmost = node;
+			_rightmost = node;
+		} else if (left) {
+			if (parent == _leftmost)
+				_leftmost = node;
+		} else {
+			if (parent == _rightmost)
+				_rightmost = node;
+		}
+
+		algorithms::insert(traits(_pool), _root, node, parent, left);
+		++_size;
+
+		return iterator(_pool, node);
+	}
+
+private:
+	T*     _pool;
+	uint32 _root;
+	uint32 _leftmost;
+	uint32 _rightmost;
+	size_t _size;
+};
+
+template<class T, index_rbtree_node T::* NodeMember, class Compare>
+inline void swap(index_rbtree<T, NodeMember, Compare>& rhs, index_rbtree<T, NodeMember, Compare>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_INDEX_RBTREE__HPP_ */
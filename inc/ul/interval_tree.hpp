@@ -0,0 +1,295 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//==============================================================================
+
+#ifndef UL_INTERVAL_TREE__HPP_
+#define UL_INTERVAL_TREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/rbtree.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Interval tree hook, a red-black tree node augmented with the
+ *        highest endpoint found on its subtree.
+ */
+template<class Key>
+struct interval_tree_node {
+	rbtree_node node;
+	Key         max;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+template<class T, class Key, interval_tree_node<Key> T::* NodeMember, class GetLow, class GetHigh>
+struct interval_tree_traits {
+	typedef interval_tree_node<Key> hook;
+
+	static T& element(hook const& h)
+	{
+		return *parent_of(const_cast<hook*>(&h), NodeMember);
+	}
+
+	static hook* hook_of(rbtree_node* node)
+	{
+		return parent_of(node, &hook::node);
+	}
+
+	static Key low(hook const& h)  { return GetLow()(element(h)); }
+	static Key high(hook const& h) { return GetHigh()(element(h)); }
+
+	//
+	// Augmentation policy for the hooks
+	//
+	static bool update(hook& h, hook const* left, hook const* right)
+	{
+		Key max = high(h);
+
+		if (left && max < left->max)
+			max = left->max;
+		if (right && max < right->max)
+			max = right->max;
+
+		if (h.max == max)
+			return false;
+
+		h.max = max;
+		return true;
+	}
+
+	static void copy(hook const& from, hook& to)
+	{
+		to.max = from.max;
+	}
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, class Key, interval_tree_node<Key> T::* NodeMember, class GetLow, class GetHigh>
+class interval_tree_iterator
+	: public boost::iterator_facade<interval_tree_iterator<T, Key, NodeMember, GetLow, GetHigh>,
+	                                T,
+	                                boost::forward_traversal_tag> {
+
+	friend class boost::iterator_core_access;
+
+	typedef detail::interval_tree_traits<typename boost::remove_const<T>::type,
+	                                     Key, NodeMember, GetLow, GetHigh> traits;
+	typedef typename traits::hook hook;
+
+public:
+	interval_tree_iterator()
+		: _node(nullptr)
+	{ }
+
+	interval_tree_iterator(rbtree_node* root, Key const& low, Key const& high)
+		: _node(nullptr), _low(low), _high(high)
+	{
+		if (root && !(traits::hook_of(root)->max < _low))
+			_node = search(root);
+	}
+
+private:
+	//
+	// Leftmost node of the subtree that overlaps [low, high], the subtree
+	// must hold an interval ending at or after low.
+	//
+	rbtree_node* search(rbtree_node* node) const
+	{
+		for (;;) {
+			if (node->left && !(traits::hook_of(node->left)->max < _low)) {
+				node = node->left;
+				continue;
+			}
+
+			hook* h = traits::hook_of(node);
+			if (!(_high < traits::low(*h))) {
+				if (!(traits::high(*h) < _low))
+					return node;
+
+				if (node->right && !(traits::hook_of(node->right)->max < _low)) {
+					node = node->right;
+					continue;
+				}
+			}
+			return nullptr;
+		}
+	}
+
+	void increment()
+	{
+		rbtree_node* node = _node;
+		rbtree_node* prev;
+
+		for (;;) {
+			if (node->right && !(traits::hook_of(node->right)->max < _low)) {
+				_node = search(node->right);
+				return;
+			}
+
+			//
+			// Move up until we come from a left child
+			//
+			do {
+				prev = node;
+				node = node->parent();
+				if (!node) {
+					_node = nullptr;
+					return;
+				}
+			} while (prev == node->right);
+
+			hook* h = traits::hook_of(node);
+			if (_high < traits::low(*h)) {
+				_node = nullptr;
+				return;
+			}
+			if (!(traits::high(*h) < _low)) {
+				_node = node;
+				return;
+			}
+		}
+	}
+
+	bool equal(interval_tree_iterator const& other) const { return _node == other._node; }
+
+	T& dereference() const { return traits::element(*traits::hook_of(_node)); }
+
+	rbtree_node* _node;
+	Key          _low;
+	Key          _high;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive interval tree over closed intervals [low, high], ordered
+ *        by their low endpoint.
+ *
+ * Overlap and stabbing queries are lazy, the first hit is found in O(log n)
+ * and each following one without revisiting the subtrees already skipped.
+ */
+template<class T, class Key, interval_tree_node<Key> T::* NodeMember, class GetLow, class GetHigh>
+class interval_tree {
+	interval_tree(const interval_tree&);
+	interval_tree& operator=(const interval_tree&);
+
+	typedef detail::interval_tree_traits<T, Key, NodeMember, GetLow, GetHigh> traits;
+	typedef typename traits::hook                                               hook;
+	typedef detail::rbtree_augment_ops<hook, &hook::node, traits>              augment_ops;
+
+public:
+	typedef T*                                                                pointer;
+	typedef T&                                                                reference;
+	typedef T const&                                                          const_reference;
+	typedef interval_tree_iterator<T, Key, NodeMember, GetLow, GetHigh>       iterator;
+	typedef interval_tree_iterator<T const, Key, NodeMember, GetLow, GetHigh> const_iterator;
+	typedef boost::iterator_range<iterator>                                   range;
+	typedef boost::iterator_range<const_iterator>                             const_range;
+
+	interval_tree()
+		: _root(nullptr)
+	{ }
+
+	void insert(reference elem)
+	{
+		hook*         h      = member_of(&elem, NodeMember);
+		Key           low    = GetLow()(elem);
+		rbtree_node*  parent = nullptr;
+		rbtree_node** next   = &_root;
+
+		while (*next) {
+			parent = *next;
+			if (low < traits::low(*traits::hook_of(parent)))
+				next = &parent->left;
+			else
+				next = &parent->right;
+		}
+		*next = &h->node;
+		augment_ops::insert(&h->node, &_root, parent);
+	}
+
+	void remove(reference elem)
+	{
+		augment_ops::remove(&member_of(&elem, NodeMember)->node, &_root);
+	}
+
+	/**
+	 * Must be called after the high endpoint of \a elem changed in place.
+	 */
+	void update(reference elem)
+	{
+		augment_ops::propagate(&member_of(&elem, NodeMember)->node, nullptr);
+	}
+
+	bool empty() const
+	{
+		return !_root;
+	}
+
+	void swap(interval_tree& other)
+	{
+		std::swap(_root, other._root);
+	}
+
+	/**
+	 * Intervals overlapping [low, high], in increasing order of low endpoint.
+	 */
+	range overlaps(Key const& low, Key const& high)
+	{
+		return range(iterator(_root, low, high), iterator());
+	}
+
+	const_range overlaps(Key const& low, Key const& high) const
+	{
+		return const_range(const_iterator(_root, low, high), const_iterator());
+	}
+
+	/**
+	 * Intervals containing \a point.
+	 */
+	range stab(Key const& point)
+	{
+		return overlaps(point, point);
+	}
+
+	const_range stab(Key const& point) const
+	{
+		return overlaps(point, point);
+	}
+
+	bool overlapped(Key const& low, Key const& high) const
+	{
+		return !overlaps(low, high).empty();
+	}
+
+private:
+	rbtree_node* _root;
+};
+
+template<class T, class Key, interval_tree_node<Key> T::* NodeMember, class GetLow, class GetHigh>
+inline void swap(interval_tree<T, Key, NodeMember, GetLow, GetHigh>& rhs,
+                 interval_tree<T, Key, NodeMember, GetLow, GetHigh>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_INTERVAL_TREE__HPP_ */
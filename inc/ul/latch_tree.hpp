@@ -0,0 +1,172 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_LATCH_TREE__HPP_
+#define UL_LATCH_TREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/rbtree.hpp>
+#include <atomic>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Latch tree hook, one red-black tree node for each copy of the tree.
+ */
+struct latch_tree_node {
+	rbtree_node node[2];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive red-black tree whose lookups run without locks alongside a
+ *        single writer.
+ *
+ * Elements are linked into two copies of the tree. The writer bumps a
+ * sequence count, which steers readers to the copy it is not about to touch,
+ * before updating each copy in turn. Readers walk the copy selected by the
+ * count and retry when it changed during the walk.
+ *
+ * Writers must be serialized by the caller. An element that was removed may
+ * still be referenced by readers that started before, so it can only be
+ * reused or freed once those are known to be done (e.g. after an RCU or
+ * epoch grace period).
+ */
+template<class T, latch_tree_node T::* NodeMember, class Compare = std::less<T> >
+class latch_tree {
+	latch_tree(const latch_tree&);
+	latch_tree& operator=(const latch_tree&);
+
+	typedef detail::rbtree_key_compare<T, Compare> key_compare;
+
+public:
+	typedef T*       pointer;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	latch_tree()
+		: _seq(0)
+	{
+		_root[0] = nullptr;
+		_root[1] = nullptr;
+	}
+
+	//
+	// Writer side
+	//
+	void insert(reference elem)
+	{
+		latch();
+		insert(elem, 0);
+		latch();
+		insert(elem, 1);
+	}
+
+	void remove(reference elem)
+	{
+		latch();
+		member_of(&elem, NodeMember)->node[0].remove(&_root[0]);
+		latch();
+		member_of(&elem, NodeMember)->node[1].remove(&_root[1]);
+	}
+
+	bool empty() const
+	{
+		return !rbtree_node::load(_root[0]);
+	}
+
+	//
+	// Reader side, safe to call concurrently with the writer
+	//
+	template<class Key>
+	pointer find(Key const& key) const
+	{
+		rbtree_node* node;
+		uint         seq;
+		uint         idx;
+
+		do {
+			seq = _seq.load(std::memory_order_acquire);
+			idx = seq & 1;
+			node = find_impl(key, idx);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while (seq != _seq.load(std::memory_order_relaxed));
+
+		return node ? element(node, idx) : nullptr;
+	}
+
+private:
+	//
+	// Readers use copy (seq & 1), so the writer moves them off the copy it
+	// is about to update
+	//
+	void latch()
+	{
+		_seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void insert(reference elem, uint idx)
+	{
+		rbtree_node*  node   = &member_of(&elem, NodeMember)->node[idx];
+		rbtree_node*  parent = nullptr;
+		rbtree_node** link   = &_root[idx];
+		Compare       cmp;
+
+		while (*link) {
+			parent = *link;
+			if (cmp(elem, *element(parent, idx)))
+				link = &parent->left;
+			else
+				link = &parent->right;
+		}
+
+		node->insert(&_root[idx], parent, link);
+	}
+
+	template<class Key>
+	rbtree_node* find_impl(Key const& key, uint idx) const
+	{
+		rbtree_node* node = rbtree_node::load(_root[idx]);
+		Compare      cmp;
+
+		while (node) {
+			T const& elem = *element(node, idx);
+
+			if (key_compare::key_less(cmp, key, elem))
+				node = rbtree_node::load(node->left);
+			else if (key_compare::elem_less(cmp, elem, key))
+				node = rbtree_node::load(node->right);
+			else
+				return node;
+		}
+
+		return nullptr;
+	}
+
+	static T* element(rbtree_node* node, uint idx)
+	{
+		return parent_of(reinterpret_cast<latch_tree_node*>(node - idx), NodeMember);
+	}
+
+private:
+	std::atomic<uint> _seq;
+	rbtree_node*      _root[2];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_LATCH_TREE__HPP_ */
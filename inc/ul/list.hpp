@@ -15,20 +15,88 @@
 #include <ul/base.hpp>
 #include <ul/list_node.hpp>
 #include <ul/list_iterator.hpp>
+#include <functional>
+#include <utility>
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace ul {
 
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+//
+// Size policies of list, either counting the elements on demand or keeping
+// their count up to date
+//
+template<bool ConstantTimeSize>
+class list_size {
+protected:
+	size_t size(list_node const& root) const
+	{
+		size_t n = 0;
+
+		for (list_node const* node = root.next; node != &root; node = node->next)
+			++n;
+
+		return n;
+	}
+
+	void add(size_t) { }
+	void sub(size_t) { }
+	void reset()     { }
+
+	void swap(list_size&) { }
+
+	static size_t distance(list_node const*, list_node const*) { return 0; }
+};
+
+template<>
+class list_size<true> {
+protected:
+	list_size()
+		: _size(0)
+	{ }
+
+	size_t size(list_node const&) const { return _size; }
+
+	void add(size_t n) { _size += n; }
+	void sub(size_t n) { _size -= n; }
+	void reset()       { _size = 0; }
+
+	void swap(list_size& other) { std::swap(_size, other._size); }
+
+	static size_t distance(list_node const* first, list_node const* last)
+	{
+		size_t n = 0;
+
+		for (; first != last; first = first->next)
+			++n;
+
+		return n;
+	}
+
+private:
+	size_t _size;
+};
+
+} /* namespace detail */
+
 ///////////////////////////////////////////////////////////////////////////////
 /**
  * \brief Linked list intrusive container that offers an interface similar to
  *        STL containers.
+ *
+ * With \a ConstantTimeSize the list keeps count of its elements, so size()
+ * takes O(1) time but splicing a range of unknown length takes O(n). Such
+ * lists expect their elements to be unlinked through them only.
  */
-template<class T, list_node T::* NodeMember>
-class list {
+template<class T, list_node T::* NodeMember, bool ConstantTimeSize = false>
+class list : private detail::list_size<ConstantTimeSize> {
 	list(const list&);
 	list& operator=(const list&);
 
+	typedef detail::list_size<ConstantTimeSize> size_policy;
+
 public:
 	typedef T*                                    pointer;
 	typedef T const*                              const_pointer;
@@ -46,14 +114,14 @@ public:
 	{ _root.remove(); }
 
 
-	void push_front(reference node) { _root.push_front(member_of(&node, NodeMember)); }
-	void push_back(reference node)  { _root.push_back(member_of(&node, NodeMember)); }
+	void push_front(reference node) { _root.push_front(member_of(&node, NodeMember)); this->add(1); }
+	void push_back(reference node)  { _root.push_back(member_of(&node, NodeMember)); this->add(1); }
 
-	pointer pop_front() { return parent_of(_root.pop_front(), NodeMember); }
-	pointer pop_back()  { return parent_of(_root.pop_back(), NodeMember); }
+	pointer pop_front() { this->sub(1); return parent_of(_root.pop_front(), NodeMember); }
+	pointer pop_back()  { this->sub(1); return parent_of(_root.pop_back(), NodeMember); }
 
 	void remove(iterator i)  { remove(*i); }
-	void remove(reference r) { member_of(&r, NodeMember)->remove(); }
+	void remove(reference r) { member_of(&r, NodeMember)->remove(); this->sub(1); }
 
 	reference front() { return *parent_of(_root.front(), NodeMember); }
 	reference back() { return *parent_of(_root.back(), NodeMember); }
@@ -63,6 +131,8 @@ public:
 
 	bool empty() const { return _root.empty(); }
 
+	size_t size() const { return size_policy::size(_root); }
+
 	iterator begin() { return iterator(_root.next); }
 	iterator end()   { return iterator(&_root); }
 
@@ -77,14 +147,254 @@ public:
 
 	void reverse() { _root.reverse(); }
 
-	void swap(list& l) { _root.swap(l._root); }
+	/**
+	 * Move every element of \a other before \a pos.
+	 */
+	void splice(iterator pos, list& other)
+	{
+		size_t n = ConstantTimeSize ? other.size() : 0;
+
+		pos.node()->splice(other._root.next, &other._root);
+		other.reset();
+		this->add(n);
+	}
+
+	/**
+	 * Move the element at \a i in \a other before \a pos.
+	 */
+	void splice(iterator pos, list& other, iterator i)
+	{
+		iterator last = i;
+
+		if (pos != i && pos != ++last)
+			splice(pos, other, i, last, 1);
+	}
+
+	/**
+	 * Move the elements in [first, last) of \a other before \a pos. Takes
+	 * O(n) time to count them with a constant time size, use the overload
+	 * taking their number instead when it is known.
+	 */
+	void splice(iterator pos, list& other, iterator first, iterator last)
+	{
+		splice(pos, other, first, last, size_policy::distance(first.node(), last.node()));
+	}
+
+	/**
+	 * Move the \a n elements in [first, last) of \a other before \a pos.
+	 */
+	void splice(iterator pos, list& other, iterator first, iterator last, size_t n)
+	{
+		pos.node()->splice(first.node(), last.node());
+		other.sub(n);
+		this->add(n);
+	}
+
+	/**
+	 * Move the elements of \a other into this list, both sorted by \a cmp,
+	 * keeping it sorted. Elements of this list come before the equivalent
+	 * ones of \a other.
+	 */
+	template<class Compare>
+	void merge(list& other, Compare cmp)
+	{
+		list_node* pos = _root.next;
+
+		while (!other.empty()) {
+			if (pos == &_root) {
+				splice(end(), other);
+				break;
+			}
+
+			if (cmp(other.front(), *parent_of(pos, NodeMember))) {
+				pos->splice(other._root.next, other._root.next->next);
+				other.sub(1);
+				this->add(1);
+			} else {
+				pos = pos->next;
+			}
+		}
+	}
+
+	void merge(list& other) { merge(other, std::less<T>()); }
+
+	/**
+	 * Stable sort of the elements by \a cmp, in O(n log n) time and without
+	 * allocating.
+	 *
+	 * The list is unlinked into a chain through the next links only and
+	 * merged bottom up, bin i holding a sorted run of 2^i elements, as in
+	 * a binary counter. The prev links are restored at the end. If \a cmp
+	 * throws, every element is put back in the list in no given order.
+	 */
+	template<class Compare>
+	void sort(Compare cmp)
+	{
+		if (_root.next == _root.prev)
+			return;
+
+		list_node* bins[sizeof(size_t) * 8] = { };
+		list_node* run  = nullptr;
+		list_node* node = _root.next;
+		uint       used = 0;
+
+		_root.prev->next = nullptr;
+
+		try {
+			while (node) {
+				uint i = 0;
+
+				run = node;
+				node = node->next;
+				run->next = nullptr;
+
+				for (; bins[i]; ++i) {
+					run = merge_chains(bins[i], run, cmp);
+					bins[i] = nullptr;
+				}
+
+				bins[i] = run;
+				run = nullptr;
+				if (i >= used)
+					used = i + 1;
+			}
+
+			//
+			// Lower bins hold the later elements
+			//
+			for (uint i = 0; i < used; ++i) {
+				if (bins[i]) {
+					run = run ? merge_chains(bins[i], run, cmp) : bins[i];
+					bins[i] = nullptr;
+				}
+			}
+		} catch (...) {
+			list_node* rest = relink(nullptr, node);
+
+			for (uint i = 0; i < used; ++i)
+				rest = relink(rest, bins[i]);
+			relink(rest, run);
+			throw;
+		}
+
+		relink(nullptr, run);
+	}
+
+	void sort() { sort(std::less<T>()); }
+
+	void clear() { clear_and_dispose(null_disposer()); }
+
+	/**
+	 * Unlink every element, handing each one to \a disposer once unlinked.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		list_node* node = _root.next;
+
+		_root.next = &_root;
+		_root.prev = &_root;
+		this->reset();
+		while (node != &_root) {
+			list_node* next = node->next;
+
+			node->next = node;
+			node->prev = node;
+			disposer(parent_of(node, NodeMember));
+			node = next;
+		}
+	}
+
+	/**
+	 * Dispose of the elements of this list and append the copies \a cloner
+	 * makes of the elements of \a other. If it throws, the copies made so
+	 * far are handed to \a disposer and this list is left empty. Cloning a
+	 * list from itself leaves it unchanged.
+	 */
+	template<class Cloner, class Disposer>
+	void clone_from(list const& other, Cloner cloner, Disposer disposer)
+	{
+		if (&other == this)
+			return;
+
+		clear_and_dispose(disposer);
+		try {
+			for (const_iterator i = other.begin(); i != other.end(); ++i)
+				push_back(*cloner(*i));
+		} catch (...) {
+			clear_and_dispose(disposer);
+			throw;
+		}
+	}
+
+	void swap(list& l) { _root.swap(l._root); size_policy::swap(l); }
 
 private:
+	struct null_disposer {
+		void operator()(pointer) const { }
+	};
+
+	//
+	// Merge two sorted chains linked through next only, taking from \a a on
+	// ties. If \a cmp throws, \a a is left holding every element and \a b
+	// none.
+	//
+	template<class Compare>
+	static list_node* merge_chains(list_node*& a, list_node*& b, Compare& cmp)
+	{
+		list_node  head(no_init);
+		list_node* tail = &head;
+
+		try {
+			while (a && b) {
+				if (cmp(*parent_of(b, NodeMember), *parent_of(a, NodeMember))) {
+					tail->next = b;
+					b = b->next;
+				} else {
+					tail->next = a;
+					a = a->next;
+				}
+				tail = tail->next;
+			}
+		} catch (...) {
+			tail->next = a;
+			while (tail->next)
+				tail = tail->next;
+			tail->next = b;
+			a = head.next;
+			b = nullptr;
+			throw;
+		}
+
+		tail->next = a ? a : b;
+		a = nullptr;
+		b = nullptr;
+		return head.next;
+	}
+
+	//
+	// Link the chain \a first after \a last, or at the front when null,
+	// restoring the prev links. Returns the new last element.
+	//
+	list_node* relink(list_node* last, list_node* first)
+	{
+		list_node* prev = last ? last : &_root;
+
+		for (prev->next = first; first; first = first->next) {
+			first->prev = prev;
+			prev = first;
+		}
+
+		prev->next = &_root;
+		_root.prev = prev;
+		return prev;
+	}
+
 	list_node _root;
 };
 
-template<class T, list_node T::* NodeMember>
-inline void swap(list<T, NodeMember>& rhs, list<T, NodeMember>& lhs)
+template<class T, list_node T::* NodeMember, bool ConstantTimeSize>
+inline void swap(list<T, NodeMember, ConstantTimeSize>& rhs, list<T, NodeMember, ConstantTimeSize>& lhs)
 {
 	rhs.swap(lhs);
 }
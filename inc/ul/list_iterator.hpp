@@ -38,6 +38,8 @@ public:
 		: _node(const_cast<list_node*>(node))
 	{ }
 
+	list_node* node() const { return _node; }
+
 private:
 	void increment() { _node = _node->next; }
 	void decrement() { _node = _node->prev; }
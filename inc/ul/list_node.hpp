@@ -77,23 +77,70 @@ struct list_node {
 	list_node* front() const { return next; }
 	list_node* back() const  { return prev; }
 
+	/**
+	 * Exchange the elements of the lists headed by this node and \a y.
+	 */
 	void swap(list_node& y)
 	{
 		list_node* n = next;
 		list_node* p = prev;
 
-		next = y.next;
-		prev = y.prev;
-		y.next = n;
-		y.prev = p;
+		if (y.empty()) {
+			next = this;
+			prev = this;
+		} else {
+			next = y.next;
+			prev = y.prev;
+			next->prev = this;
+			prev->next = this;
+		}
+
+		if (n == this) {
+			y.next = &y;
+			y.prev = &y;
+		} else {
+			y.next = n;
+			y.prev = p;
+			n->prev = &y;
+			p->next = &y;
+		}
 	}
 
+	/**
+	 * Reverse the order of the list headed by this node.
+	 */
 	void reverse()
 	{
-		list_node* n = next;
+		list_node* node = this;
+
+		do {
+			list_node* n = node->next;
+
+			node->next = node->prev;
+			node->prev = n;
+			node = n;
+		} while (node != this);
+	}
+
+	/**
+	 * Move the nodes in [first, last) before this node, \a first and \a last
+	 * may belong to any list, including this one as long as this node is not
+	 * in the range.
+	 */
+	void splice(list_node* first, list_node* last)
+	{
+		if (first == last)
+			return;
+
+		list_node* tail = last->prev;
+
+		first->prev->next = last;
+		last->prev = first->prev;
 
-		next = prev;
-		prev = n;
+		prev->next = first;
+		first->prev = prev;
+		tail->next = this;
+		prev = tail;
 	}
 
 	void unlink()
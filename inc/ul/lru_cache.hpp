@@ -0,0 +1,401 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_LRU_CACHE__HPP_
+#define UL_LRU_CACHE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/hash_table.hpp>
+#include <ul/list.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Cache hook, the links of an element into the index and into the
+ *        recency list of its shard. Copies start unlinked.
+ */
+class lru_cache_node {
+	template<class T, lru_cache_node T::* NodeMember, class Hash, class Eq>
+	friend class lru_cache;
+
+public:
+	lru_cache_node()
+		: _referenced(false)
+	{ }
+
+	lru_cache_node(lru_cache_node const&)
+		: _referenced(false)
+	{ }
+
+	lru_cache_node& operator=(lru_cache_node const&)
+	{
+		return *this;
+	}
+
+	bool cached() const { return !_list.empty(); }
+
+private:
+	hash_table_node   _hash;
+	list_node         _list;
+	std::atomic<bool> _referenced;
+};
+
+/**
+ * \brief How a lru_cache picks the element to evict.
+ *
+ * - lru_mode:   elements found are moved to the front of the recency list,
+ *               the one at the back is evicted.
+ * - clock_mode: elements found are only marked as referenced, so lookups
+ *               leave the list alone and share the lock of the shard.
+ *               Eviction moves the marked elements at the back to the
+ *               front, clearing the mark, and evicts the first one left
+ *               unmarked (second chance).
+ */
+enum lru_cache_mode {
+	lru_mode,
+	clock_mode
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive cache of at most \a capacity elements, split in shards
+ *        that each have their own lock, index and recency list.
+ *
+ * An element goes to the shard picked by its hash, each shard holds up to
+ * its share of the capacity and evicts on its own. Lookups, inserts and
+ * removals only lock the shard of the key. Evicted and removed elements are
+ * handed to a disposer once the shard is unlocked, so it may free them.
+ *
+ * Hash and Eq are as for hash_table.
+ */
+template<class T, lru_cache_node T::* NodeMember, class Hash = std::hash<T>, class Eq = std::equal_to<T> >
+class lru_cache {
+	lru_cache(const lru_cache&);
+	lru_cache& operator=(const lru_cache&);
+
+	static T const& element(lru_cache_node const& node)
+	{
+		return *parent_of(const_cast<lru_cache_node*>(&node), NodeMember);
+	}
+
+	struct node_hash {
+		size_t operator()(lru_cache_node const& node) const { return Hash()(element(node)); }
+
+		template<class Key>
+		size_t operator()(Key const& key) const { return Hash()(key); }
+	};
+
+	struct node_equal {
+		bool operator()(lru_cache_node const& lhs, lru_cache_node const& rhs) const { return Eq()(element(lhs), element(rhs)); }
+
+		template<class Key>
+		bool operator()(Key const& key, lru_cache_node const& node) const { return Eq()(key, element(node)); }
+	};
+
+	typedef hash_table<lru_cache_node, &lru_cache_node::_hash, node_hash, node_equal> index_type;
+	typedef list<lru_cache_node, &lru_cache_node::_list>                              list_type;
+
+	typedef boost::shared_mutex           lock_type;
+	typedef std::lock_guard<lock_type>    exclusive_lock;
+	typedef boost::shared_lock<lock_type> shared_lock;
+
+	//
+	// Padded so that the locks of different shards do not share a cache line
+	//
+	struct shard {
+		lock_type  lock;
+		index_type index;
+		list_type  recency;
+		size_t     size;
+		size_t     capacity;
+		char       pad[64];
+	};
+
+public:
+	typedef T*       pointer;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	explicit lru_cache(size_t capacity, uint shards = 16, lru_cache_mode mode = lru_mode)
+		: _shards(new shard[shards ? shards : 1]), _count(shards ? shards : 1), _mode(mode)
+	{
+		for (uint i = 0; i < _count; ++i) {
+			_shards[i].size = 0;
+			_shards[i].capacity = std::max<size_t>(capacity / _count + (i < capacity % _count), 1);
+		}
+	}
+
+	~lru_cache()
+	{
+		delete[] _shards;
+	}
+
+	/**
+	 * Insert \a elem unless an equal element is cached, returning whether it
+	 * was inserted. When the shard is full, an element is evicted to make
+	 * room and handed to \a disposer.
+	 */
+	template<class Disposer>
+	bool insert(reference elem, Disposer disposer)
+	{
+		return insert(elem, disposer, null_visitor());
+	}
+
+	/**
+	 * Same as above, an equal element already cached being touched instead
+	 * and handed to \a f while its shard is locked.
+	 */
+	template<class Disposer, class F>
+	bool insert(reference elem, Disposer disposer, F f)
+	{
+		lru_cache_node* node    = member_of(&elem, NodeMember);
+		size_t          hash    = Hash()(elem);
+		shard&          s       = shard_of(hash);
+		lru_cache_node* evicted = nullptr;
+
+		{
+			exclusive_lock guard(s.lock);
+
+			typename index_type::iterator i = s.index.find(*node);
+
+			if (i != s.index.end()) {
+				touch(s, &*i);
+				f(*parent_of(&*i, NodeMember));
+				return false;
+			}
+
+			s.index.insert_equal(*node);
+			if (s.size == s.capacity)
+				evicted = evict(s);
+
+			node->_referenced.store(false, std::memory_order_relaxed);
+			s.recency.push_front(*node);
+			++s.size;
+		}
+
+		if (evicted)
+			disposer(parent_of(evicted, NodeMember));
+
+		return true;
+	}
+
+	/**
+	 * Look up \a key, touching the element found and handing it to \a f
+	 * while its shard is locked. Returns false if no element matched.
+	 *
+	 * In clock_mode the lock is shared with other lookups, so \a f may run
+	 * concurrently with others on the same element.
+	 */
+	template<class Key, class F>
+	bool find(Key const& key, F f)
+	{
+		shard& s = shard_of(Hash()(key));
+
+		if (_mode == clock_mode) {
+			shared_lock guard(s.lock);
+
+			return find_impl(s, key, f);
+		}
+
+		exclusive_lock guard(s.lock);
+
+		return find_impl(s, key, f);
+	}
+
+	/**
+	 * Remove the element matching \a key and hand it to \a disposer.
+	 */
+	template<class Key, class Disposer>
+	bool remove(Key const& key, Disposer disposer)
+	{
+		shard&          s    = shard_of(Hash()(key));
+		lru_cache_node* node = nullptr;
+
+		{
+			exclusive_lock guard(s.lock);
+
+			typename index_type::iterator i = s.index.find(key);
+
+			if (i == s.index.end())
+				return false;
+
+			node = &*i;
+			unlink(s, node);
+		}
+
+		disposer(parent_of(node, NodeMember));
+		return true;
+	}
+
+	/**
+	 * Remove \a elem, returning false if it was not cached.
+	 */
+	bool remove(reference elem)
+	{
+		lru_cache_node* node = member_of(&elem, NodeMember);
+		shard&          s    = shard_of(Hash()(elem));
+		exclusive_lock  guard(s.lock);
+
+		if (!node->cached())
+			return false;
+
+		unlink(s, node);
+		return true;
+	}
+
+	/**
+	 * Remove every element, handing each one to \a disposer. Shards are
+	 * emptied one at a time.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		for (uint i = 0; i < _count; ++i) {
+			shard&    s = _shards[i];
+			list_type elems;
+
+			{
+				exclusive_lock guard(s.lock);
+
+				s.index.clear();
+				s.recency.swap(elems);
+				s.size = 0;
+			}
+
+			while (!elems.empty()) {
+				lru_cache_node* node = elems.pop_front();
+
+				reset(node);
+				disposer(parent_of(node, NodeMember));
+			}
+		}
+	}
+
+	/**
+	 * Number of elements, which may be stale by the time it returns when
+	 * other threads update the cache.
+	 */
+	size_t size() const
+	{
+		size_t n = 0;
+
+		for (uint i = 0; i < _count; ++i) {
+			shared_lock guard(_shards[i].lock);
+
+			n += _shards[i].size;
+		}
+
+		return n;
+	}
+
+	size_t capacity() const
+	{
+		size_t n = 0;
+
+		for (uint i = 0; i < _count; ++i)
+			n += _shards[i].capacity;
+
+		return n;
+	}
+
+private:
+	//
+	// The hash is mixed with another constant than the one hash_table uses,
+	// so that elements of a shard still spread over all of its buckets
+	//
+	shard& shard_of(size_t hash) const
+	{
+		return _shards[(uint64(hash) * 0xc2b2ae3d27d4eb4fULL >> 32) % _count];
+	}
+
+	struct null_visitor {
+		void operator()(reference) const { }
+	};
+
+	template<class Key, class F>
+	bool find_impl(shard& s, Key const& key, F& f)
+	{
+		typename index_type::iterator i = s.index.find(key);
+
+		if (i == s.index.end())
+			return false;
+
+		touch(s, &*i);
+		f(*parent_of(&*i, NodeMember));
+		return true;
+	}
+
+	//
+	// In clock_mode lookups only hold the lock shared, the mark is left as
+	// is when already set so that they do not all write to the element
+	//
+	void touch(shard& s, lru_cache_node* node)
+	{
+		if (_mode == clock_mode) {
+			if (!node->_referenced.load(std::memory_order_relaxed))
+				node->_referenced.store(true, std::memory_order_relaxed);
+			return;
+		}
+
+		node->_list.unlink();
+		s.recency.push_front(*node);
+	}
+
+	lru_cache_node* evict(shard& s)
+	{
+		lru_cache_node* node;
+
+		//
+		// In lru_mode no element is ever marked
+		//
+		while ((node = &s.recency.back())->_referenced.load(std::memory_order_relaxed)) {
+			node->_referenced.store(false, std::memory_order_relaxed);
+			node->_list.unlink();
+			s.recency.push_front(*node);
+		}
+
+		unlink(s, node);
+		return node;
+	}
+
+	void unlink(shard& s, lru_cache_node* node)
+	{
+		s.index.remove(*node);
+		node->_list.unlink();
+		reset(node);
+		--s.size;
+	}
+
+	static void reset(lru_cache_node* node)
+	{
+		node->_list.next = &node->_list;
+		node->_list.prev = &node->_list;
+	}
+
+private:
+	shard*         _shards;
+	uint           _count;
+	lru_cache_mode _mode;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_LRU_CACHE__HPP_ */
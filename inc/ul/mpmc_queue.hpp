@@ -0,0 +1,265 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_MPMC_QUEUE__HPP_
+#define UL_MPMC_QUEUE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/buffer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Bounded lock-free multi-producer multi-consumer queue, after Dmitry
+ *        Vyukov's ring of sequenced slots.
+ *
+ * The capacity is rounded up to a power of two and the slots are allocated
+ * once, in a ul::buffer. Each slot carries a sequence number telling whether
+ * it is free for the producer of a position or holds the value for its
+ * consumer, so producers and consumers only contend on their own index.
+ *
+ * The try_ variants fail instead of waiting when the queue is full or empty,
+ * the others spin, yielding the processor, until they succeed. Batch
+ * variants claim as many consecutive slots as they can with a single swap.
+ * Copying or moving T must not throw.
+ */
+template<class T>
+class mpmc_queue {
+	mpmc_queue(const mpmc_queue&);
+	mpmc_queue& operator=(const mpmc_queue&);
+
+	struct slot {
+		std::atomic<size_t>                                        seq;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+	};
+
+	UL_STATIC_ASSERT(alignof(slot) <= alignof(std::max_align_t), "T is over-aligned for ul::buffer storage");
+
+	static const uint k_spins = 64;
+
+public:
+	typedef T        value_type;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	explicit mpmc_queue(size_t capacity)
+		: _mask(0), _head(0), _tail(0)
+	{
+		size_t n = 2;
+
+		while (n < capacity)
+			n <<= 1;
+
+		_storage.size(n * sizeof(slot));
+		_slots = reinterpret_cast<slot*>(_storage.get());
+		_mask = n - 1;
+
+		for (size_t i = 0; i < n; ++i)
+			new (&_slots[i].seq) std::atomic<size_t>(i);
+	}
+
+	~mpmc_queue()
+	{
+		size_t head = _head.load(std::memory_order_relaxed);
+		size_t tail = _tail.load(std::memory_order_relaxed);
+
+		for (; head != tail; ++head)
+			value_of(slot_of(head))->~T();
+	}
+
+	bool try_push(const_reference value) { return emplace(value, false); }
+	bool try_push(T&& value)             { return emplace(std::move(value), false); }
+
+	void push(const_reference value) { emplace(value, true); }
+	void push(T&& value)             { emplace(std::move(value), true); }
+
+	bool try_pop(reference value) { return take(value, false); }
+	void pop(reference value)     { take(value, true); }
+
+	/**
+	 * Push copies of up to \a n values from \a values, as many as there are
+	 * free slots for, and return their number.
+	 */
+	size_t try_push(T const* values, size_t n)
+	{
+		size_t pos;
+		size_t count = claim(_tail, 0, n, pos);
+
+		for (size_t i = 0; i < count; ++i) {
+			slot& s = slot_of(pos + i);
+
+			new (&s.value) T(values[i]);
+			s.seq.store(pos + i + 1, std::memory_order_release);
+		}
+
+		return count;
+	}
+
+	/**
+	 * Pop up to \a n values into \a values, as many as there are, and
+	 * return their number.
+	 */
+	size_t try_pop(T* values, size_t n)
+	{
+		size_t pos;
+		size_t count = claim(_head, 1, n, pos);
+
+		for (size_t i = 0; i < count; ++i) {
+			slot& s = slot_of(pos + i);
+			T*    v = value_of(s);
+
+			values[i] = std::move(*v);
+			v->~T();
+			s.seq.store(pos + i + _mask + 1, std::memory_order_release);
+		}
+
+		return count;
+	}
+
+	/**
+	 * Number of values, which may be stale by the time it returns when
+	 * other threads update the queue.
+	 */
+	size_t size() const
+	{
+		size_t head = _head.load(std::memory_order_acquire);
+		size_t tail = _tail.load(std::memory_order_acquire);
+
+		//
+		// The head loaded first may be stale by the time the tail is, but
+		// never ahead of it
+		//
+		return std::min(tail - head, _mask + 1);
+	}
+
+	bool empty() const
+	{
+		return !size();
+	}
+
+	size_t capacity() const
+	{
+		return _mask + 1;
+	}
+
+private:
+	slot& slot_of(size_t pos) const
+	{
+		return _slots[pos & _mask];
+	}
+
+	static T* value_of(slot& s)
+	{
+		return reinterpret_cast<T*>(&s.value);
+	}
+
+	template<class U>
+	bool emplace(U&& value, bool wait)
+	{
+		size_t pos;
+
+		if (!claim(_tail, 0, 1, pos, wait))
+			return false;
+
+		slot& s = slot_of(pos);
+
+		new (&s.value) T(std::forward<U>(value));
+		s.seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool take(reference value, bool wait)
+	{
+		size_t pos;
+
+		if (!claim(_head, 1, 1, pos, wait))
+			return false;
+
+		slot& s = slot_of(pos);
+		T*    v = value_of(s);
+
+		value = std::move(*v);
+		v->~T();
+		s.seq.store(pos + _mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	//
+	// Claim up to n consecutive positions from index, producers passing 0
+	// and consumers 1 as the lag of the sequence number of a slot ready for
+	// them. Returns the number claimed, the first being stored in pos.
+	// Checking the slots before swapping the index is enough, as they only
+	// move on once claimed.
+	//
+	size_t claim(std::atomic<size_t>& index, size_t lag, size_t n, size_t& pos, bool wait = false)
+	{
+		uint spins = 0;
+
+		n = std::min(n, _mask + 1);
+		pos = index.load(std::memory_order_relaxed);
+
+		for (;;) {
+			size_t count = 0;
+
+			while (count < n && slot_of(pos + count).seq.load(std::memory_order_acquire) == pos + count + lag)
+				++count;
+
+			if (count) {
+				if (index.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+					return count;
+				continue;
+			}
+
+			//
+			// The slot is still in use a lap behind, the queue is full or
+			// empty, otherwise another thread claimed it first
+			//
+			sintptr diff = sintptr(slot_of(pos).seq.load(std::memory_order_acquire) - (pos + lag));
+
+			if (diff < 0) {
+				if (!wait || !n)
+					return 0;
+
+				if (++spins >= k_spins) {
+					spins = 0;
+					std::this_thread::yield();
+				}
+			}
+
+			pos = index.load(std::memory_order_relaxed);
+		}
+	}
+
+private:
+	buffer<char>        _storage;
+	slot*               _slots;
+	size_t              _mask;
+	char                _pad0[64];
+	std::atomic<size_t> _head;
+	char                _pad1[64];
+	std::atomic<size_t> _tail;
+	char                _pad2[64];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_MPMC_QUEUE__HPP_ */
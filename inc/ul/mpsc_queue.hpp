@@ -0,0 +1,164 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_MPSC_QUEUE__HPP_
+#define UL_MPSC_QUEUE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Defines a raw atomic queue hook, the link to the element queued
+ *        after this one. Copies start unlinked.
+ */
+struct mpsc_queue_node {
+	mpsc_queue_node()
+		: next(nullptr)
+	{ }
+
+	mpsc_queue_node(mpsc_queue_node const&)
+		: next(nullptr)
+	{ }
+
+	mpsc_queue_node& operator=(mpsc_queue_node const&)
+	{
+		return *this;
+	}
+
+
+	std::atomic<mpsc_queue_node*> next;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive multi-producer single-consumer queue, after Dmitry
+ *        Vyukov's algorithm.
+ *
+ * Any thread may push, taking one atomic exchange and no allocation nor
+ * lock. Only one thread at a time may pop. The queue always holds a stub
+ * node, put back at the end whenever the consumer reaches the last element,
+ * so producers never have to deal with an empty queue.
+ *
+ * A producer links its element in two steps, swapping it in as the head and
+ * then linking the previous head to it. pop() returns null while it waits
+ * on the second step, even though more elements may follow, so consumers
+ * that are woken up for each push should retry.
+ */
+template<class T, mpsc_queue_node T::* NodeMember>
+class mpsc_queue {
+	mpsc_queue(const mpsc_queue&);
+	mpsc_queue& operator=(const mpsc_queue&);
+
+public:
+	typedef T*       pointer;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	mpsc_queue()
+		: _head(&_stub), _tail(&_stub)
+	{ }
+
+	/**
+	 * Append \a elem, may be called from any thread.
+	 */
+	void push(reference elem)
+	{
+		link(member_of(&elem, NodeMember));
+	}
+
+	/**
+	 * Remove the first element, or return null if there is none. Consumer
+	 * only.
+	 */
+	pointer pop()
+	{
+		mpsc_queue_node* tail = _tail;
+		mpsc_queue_node* next = tail->next.load(std::memory_order_acquire);
+
+		if (tail == &_stub) {
+			if (!next)
+				return nullptr;
+
+			_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next) {
+			_tail = next;
+			return parent_of(tail, NodeMember);
+		}
+
+		//
+		// The tail is the last element linked, unless a push is under way.
+		// In the latter case its element is still to be linked to the tail.
+		//
+		if (tail != _head.load(std::memory_order_acquire))
+			return nullptr;
+
+		link(&_stub);
+
+		next = tail->next.load(std::memory_order_acquire);
+		if (next) {
+			_tail = next;
+			return parent_of(tail, NodeMember);
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * Whether the consumer has nothing to pop. Consumer only.
+	 */
+	bool empty() const
+	{
+		return _tail == &_stub && !_stub.next.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Pop every element, handing each one to \a disposer. Consumer only.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		while (pointer elem = pop())
+			disposer(elem);
+	}
+
+private:
+	void link(mpsc_queue_node* node)
+	{
+		node->next.store(nullptr, std::memory_order_relaxed);
+
+		mpsc_queue_node* prev = _head.exchange(node, std::memory_order_acq_rel);
+
+		prev->next.store(node, std::memory_order_release);
+	}
+
+private:
+	//
+	// Producers and the consumer work on different cache lines
+	//
+	std::atomic<mpsc_queue_node*> _head;
+	char                          _pad[64];
+	mpsc_queue_node*              _tail;
+	mpsc_queue_node               _stub;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_MPSC_QUEUE__HPP_ */
@@ -0,0 +1,512 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_OFFSET_RBTREE__HPP_
+#define UL_OFFSET_RBTREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/rbtree.hpp>
+#include <ul/rbtree_algorithms.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <iterator>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Red-black tree hook whose links are offsets from the link itself,
+ *        so that a tree keeps working wherever its memory is mapped.
+ *
+ * A null link is stored as 0, which no node can be relative to itself, and
+ * the color takes the low bit of the parent offset. Copies of a hook start
+ * unlinked.
+ */
+struct offset_rbtree_node {
+	offset_rbtree_node()
+		: _parent(0), _left(0), _right(0)
+	{ }
+
+	offset_rbtree_node(offset_rbtree_node const&)
+		: _parent(0), _left(0), _right(0)
+	{ }
+
+	offset_rbtree_node& operator=(offset_rbtree_node const&)
+	{
+		return *this;
+	}
+
+	void parent(offset_rbtree_node* p)
+	{
+		_parent = encode(&_parent, p) | (_parent & k_color_bit);
+	}
+	offset_rbtree_node* parent() const
+	{
+		return decode(&_parent, _parent & ~k_color_bit);
+	}
+
+	void left(offset_rbtree_node* l)  { _left = encode(&_left, l); }
+	void right(offset_rbtree_node* r) { _right = encode(&_right, r); }
+
+	offset_rbtree_node* left() const  { return decode(&_left, _left); }
+	offset_rbtree_node* right() const { return decode(&_right, _right); }
+
+	void color(rbtree_node::color_type c)
+	{
+		_parent = (_parent & ~k_color_bit) | (c == rbtree_node::black ? k_color_bit : 0);
+	}
+	rbtree_node::color_type color() const
+	{
+		return (_parent & k_color_bit) ? rbtree_node::black : rbtree_node::red;
+	}
+
+	//
+	// Self-relative links, also used by the trees for their root
+	//
+	static sintptr encode(sintptr const* link, offset_rbtree_node const* node)
+	{
+		return node ? reinterpret_cast<char const*>(node) - reinterpret_cast<char const*>(link) : 0;
+	}
+
+	static offset_rbtree_node* decode(sintptr const* link, sintptr offset)
+	{
+		return offset ? reinterpret_cast<offset_rbtree_node*>(const_cast<char*>(
+		                    reinterpret_cast<char const*>(link) + offset))
+		              : nullptr;
+	}
+
+private:
+	static const sintptr k_color_bit = 0x1;
+
+	sintptr _parent;
+	sintptr _left;
+	sintptr _right;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+struct offset_rbtree_traits {
+	typedef offset_rbtree_node* node_ptr;
+
+	static node_ptr null() { return nullptr; }
+
+	node_ptr parent(node_ptr n) const             { return n->parent(); }
+	void     parent(node_ptr n, node_ptr p) const { n->parent(p); }
+	node_ptr left(node_ptr n) const               { return n->left(); }
+	void     left(node_ptr n, node_ptr l) const   { n->left(l); }
+	node_ptr right(node_ptr n) const              { return n->right(); }
+	void     right(node_ptr n, node_ptr r) const  { n->right(r); }
+
+	rbtree_node::color_type color(node_ptr n) const                            { return n->color(); }
+	void                    color(node_ptr n, rbtree_node::color_type c) const { n->color(c); }
+};
+
+typedef rbtree_algorithms<offset_rbtree_traits> offset_rbtree_algorithms;
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, offset_rbtree_node T::* NodeMember>
+class offset_rbtree_iterator
+	: public boost::iterator_facade<offset_rbtree_iterator<T, NodeMember>, T, boost::bidirectional_traversal_tag> {
+
+	friend class boost::iterator_core_access;
+
+	typedef detail::offset_rbtree_traits     traits;
+	typedef detail::offset_rbtree_algorithms algorithms;
+
+	//
+	// As with rbtree_iterator, the end iterator is the last node tagged as
+	// out of range
+	//
+	static const uintptr k_out_of_range_bit = 0x1;
+
+public:
+	offset_rbtree_iterator()
+		: _iptr(0)
+	{ }
+
+	explicit offset_rbtree_iterator(offset_rbtree_node* node)
+		: _iptr(reinterpret_cast<uintptr>(node))
+	{ }
+
+	offset_rbtree_iterator(offset_rbtree_node* node, rbtree_out_of_range_tag)
+		: _iptr(reinterpret_cast<uintptr>(node) | k_out_of_range_bit)
+	{ }
+
+	offset_rbtree_node* node() const { return reinterpret_cast<offset_rbtree_node*>(_iptr & ~k_out_of_range_bit); }
+
+private:
+	void increment()
+	{
+		offset_rbtree_node* next = algorithms::next(traits(), node());
+
+		if (next)
+			_iptr = reinterpret_cast<uintptr>(next);
+		else
+			_iptr |= k_out_of_range_bit;
+	}
+
+	void decrement()
+	{
+		if (_iptr & k_out_of_range_bit) {
+			_iptr &= ~k_out_of_range_bit;
+			return;
+		}
+
+		offset_rbtree_node* prev = algorithms::prev(traits(), node());
+
+		if (prev)
+			_iptr = reinterpret_cast<uintptr>(prev);
+		else
+			_iptr |= k_out_of_range_bit;
+	}
+
+	bool equal(offset_rbtree_iterator const& other) const { return _iptr == other._iptr; }
+
+	T& dereference() const { return *parent_of(node(), NodeMember); }
+
+	uintptr _iptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive red-black tree that is position independent, all of its
+ *        links, including the root, are self-relative offsets.
+ *
+ * A tree constructed in a shared memory segment or a memory mapped file,
+ * together with its elements, can be used as is by any process that maps
+ * the same memory, at any address. The elements must not hold pointers of
+ * their own for this to work. Iterators are plain pointers and only valid
+ * in the process that took them.
+ */
+template<class T, offset_rbtree_node T::* NodeMember, class Compare = std::less<T> >
+class offset_rbtree {
+	offset_rbtree(const offset_rbtree&);
+	offset_rbtree& operator=(const offset_rbtree&);
+
+	typedef detail::offset_rbtree_traits           traits;
+	typedef detail::offset_rbtree_algorithms       algorithms;
+	typedef detail::rbtree_key_compare<T, Compare> key_compare;
+
+public:
+	typedef T*                                            pointer;
+	typedef T&                                            reference;
+	typedef T const&                                      const_reference;
+	typedef offset_rbtree_iterator<T, NodeMember>         iterator;
+	typedef offset_rbtree_iterator<T const, NodeMember>   const_iterator;
+	typedef std::reverse_iterator<iterator>               reverse_iterator;
+	typedef std::reverse_iterator<const_iterator>         const_reverse_iterator;
+
+	offset_rbtree()
+		: _root(0), _leftmost(0), _rightmost(0), _size(0)
+	{ }
+
+	iterator insert_equal(reference elem)
+	{
+		offset_rbtree_node* node   = member_of(&elem, NodeMember);
+		offset_rbtree_node* parent = nullptr;
+		bool                left   = false;
+		Compare             cmp;
+
+		for (offset_rbtree_node* next = root(); next;) {
+			parent = next;
+			left = cmp(elem, *parent_of(next, NodeMember));
+			next = left ? next->left() : next->right();
+		}
+
+		return link(node, parent, left);
+	}
+
+	std::pair<iterator, bool> insert_unique(reference elem)
+	{
+		offset_rbtree_node* node   = member_of(&elem, NodeMember);
+		offset_rbtree_node* parent = nullptr;
+		bool                left   = false;
+		Compare             cmp;
+
+		for (offset_rbtree_node* next = root(); next;) {
+			T& other = *parent_of(next, NodeMember);
+
+			parent = next;
+			left = cmp(elem, other);
+			if (!left && !cmp(other, elem))
+				return std::pair<iterator, bool>(iterator(next), false);
+			next = left ? next->left() : next->right();
+		}
+
+		return std::pair<iterator, bool>(link(node, parent, left), true);
+	}
+
+	template<class Key>
+	iterator find(Key const& key)
+	{
+		return make_iterator<iterator>(find_impl(key));
+	}
+
+	template<class Key>
+	const_iterator find(Key const& key) const
+	{
+		return make_iterator<const_iterator>(find_impl(key));
+	}
+
+	template<class Key>
+	iterator lower_bound(Key const& key)
+	{
+		return make_iterator<iterator>(bound_impl<false>(key));
+	}
+
+	template<class Key>
+	const_iterator lower_bound(Key const& key) const
+	{
+		return make_iterator<const_iterator>(bound_impl<false>(key));
+	}
+
+	template<class Key>
+	iterator upper_bound(Key const& key)
+	{
+		return make_iterator<iterator>(bound_impl<true>(key));
+	}
+
+	template<class Key>
+	const_iterator upper_bound(Key const& key) const
+	{
+		return make_iterator<const_iterator>(bound_impl<true>(key));
+	}
+
+	void remove(iterator i)
+	{
+		remove(*i);
+	}
+
+	void remove(reference elem)
+	{
+		offset_rbtree_node* node = member_of(&elem, NodeMember);
+		offset_rbtree_node* r    = root();
+
+		if (node == leftmost())
+			leftmost(algorithms::next(traits(), node));
+		if (node == rightmost())
+			rightmost(algorithms::prev(traits(), node));
+
+		algorithms::erase(traits(), r, node);
+		root(r);
+		--_size;
+	}
+
+	template<class Key>
+	bool remove(Key const& key)
+	{
+		offset_rbtree_node* node = find_impl(key);
+		if (!node)
+			return false;
+
+		remove(*parent_of(node, NodeMember));
+		return true;
+	}
+
+	bool empty() const
+	{
+		return !_root;
+	}
+
+	size_t size() const
+	{
+		return static_cast<size_t>(_size);
+	}
+
+	void swap(offset_rbtree& other)
+	{
+		offset_rbtree_node* r = root();
+		offset_rbtree_node* l = leftmost();
+		offset_rbtree_node* m = rightmost();
+
+		root(other.root());
+		leftmost(other.leftmost());
+		rightmost(other.rightmost());
+		other.root(r);
+		other.leftmost(l);
+		other.rightmost(m);
+		std::swap(_size, other._size);
+	}
+
+	//
+	// The first and last elements are cached, so that iterating takes O(1)
+	// amortized time per step as with rbtree
+	//
+	iterator begin()
+	{
+		return empty() ? end() : iterator(leftmost());
+	}
+
+	iterator end()
+	{
+		return make_iterator<iterator>(nullptr);
+	}
+
+	const_iterator begin() const
+	{
+		return empty() ? end() : const_iterator(leftmost());
+	}
+
+	const_iterator end() const
+	{
+		return make_iterator<const_iterator>(nullptr);
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+private:
+	offset_rbtree_node* root() const
+	{
+		return offset_rbtree_node::decode(&_root, _root);
+	}
+
+	void root(offset_rbtree_node* node)
+	{
+		_root = offset_rbtree_node::encode(&_root, node);
+	}
+
+	offset_rbtree_node* leftmost() const
+	{
+		return offset_rbtree_node::decode(&_leftmost, _leftmost);
+	}
+
+	void leftmost(offset_rbtree_node* node)
+	{
+		_leftmost = offset_rbtree_node::encode(&_leftmost, node);
+	}
+
+	offset_rbtree_node* rightmost() const
+	{
+		return offset_rbtree_node::decode(&_rightmost, _rightmost);
+	}
+
+	void rightmost(offset_rbtree_node* node)
+	{
+		_rightmost = offset_rbtree_node::encode(&_rightmost, node);
+	}
+
+	iterator link(offset_rbtree_node* node, offset_rbtree_node* parent, bool left)
+	{
+		offset_rbtree_node* r = root();
+
+		if (!parent) {
+			leftmost(node);
+			rightmost(node);
+		} else if (left) {
+			if (parent == leftmost())
+				leftmost(node);
+		} else {
+			if (parent == rightmost())
+				rightmost(node);
+		}
+
+		algorithms::insert(traits(), r, node, parent, left);
+		root(r);
+		++_size;
+
+		return iterator(node);
+	}
+
+	template<class Key>
+	offset_rbtree_node* find_impl(Key const& key) const
+	{
+		offset_rbtree_node* next = root();
+		Compare             cmp;
+
+		while (next) {
+			T const& elem = *parent_of(next, NodeMember);
+
+			if (key_compare::key_less(cmp, key, elem))
+				next = next->left();
+			else if (key_compare::elem_less(cmp, elem, key))
+				next = next->right();
+			else
+				return next;
+		}
+
+		return nullptr;
+	}
+
+	//
+	// First element not ordered before key or, with Upper, after it
+	//
+	template<bool Upper, class Key>
+	offset_rbtree_node* bound_impl(Key const& key) const
+	{
+		offset_rbtree_node* next  = root();
+		offset_rbtree_node* bound = nullptr;
+		Compare             cmp;
+
+		while (next) {
+			T const& elem = *parent_of(next, NodeMember);
+
+			if (Upper ? key_compare::key_less(cmp, key, elem) : !key_compare::elem_less(cmp, elem, key)) {
+				bound = next;
+				next = next->left();
+			} else {
+				next = next->right();
+			}
+		}
+
+		return bound;
+	}
+
+	template<class Iterator>
+	Iterator make_iterator(offset_rbtree_node* node) const
+	{
+		if (node)
+			return Iterator(node);
+		if (empty())
+			return Iterator();
+
+		return Iterator(rightmost(), rbtree_out_of_range_tag());
+	}
+
+private:
+	sintptr _root;
+	sintptr _leftmost;
+	sintptr _rightmost;
+	uint64  _size;
+};
+
+template<class T, offset_rbtree_node T::* NodeMember, class Compare>
+inline void swap(offset_rbtree<T, NodeMember, Compare>& rhs, offset_rbtree<T, NodeMember, Compare>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_OFFSET_RBTREE__HPP_ */
@@ -0,0 +1,278 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_PAIRING_HEAP__HPP_
+#define UL_PAIRING_HEAP__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/debug.hpp>
+#include <algorithm>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Pairing heap hook, each node links to its first child and to its
+ *        siblings.
+ *
+ * The prev link of the first child points to its parent, it is null for the
+ * root of the heap.
+ */
+struct pairing_heap_node {
+	pairing_heap_node()
+		: child(nullptr), next(nullptr), prev(nullptr)
+	{ }
+
+	pairing_heap_node* child;
+	pairing_heap_node* next;
+	pairing_heap_node* prev;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive pairing heap, top() is an element no other compares less
+ *        than with \a Compare.
+ *
+ * push(), decrease() and merge() take O(1) time, pop(), erase() and
+ * update() take O(log n) amortized time.
+ */
+template<class T, pairing_heap_node T::* NodeMember, class Compare = std::less<T> >
+class pairing_heap {
+	pairing_heap(const pairing_heap&);
+	pairing_heap& operator=(const pairing_heap&);
+
+public:
+	typedef T*       pointer;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	pairing_heap()
+		: _root(nullptr), _size(0)
+	{ }
+
+	void push(reference elem)
+	{
+		pairing_heap_node* node = member_of(&elem, NodeMember);
+
+		node->child = nullptr;
+		node->next = nullptr;
+		node->prev = nullptr;
+		_root = meld(_root, node);
+		++_size;
+	}
+
+	reference top()
+	{
+		UL_ASSERT(_root);
+		return *parent_of(_root, NodeMember);
+	}
+
+	const_reference top() const
+	{
+		UL_ASSERT(_root);
+		return *parent_of(_root, NodeMember);
+	}
+
+	void pop()
+	{
+		pairing_heap_node* root = _root;
+
+		UL_ASSERT(root);
+		_root = merge_pairs(root->child);
+		root->child = nullptr;
+		--_size;
+	}
+
+	/**
+	 * Unlink \a elem, wherever it is in the heap. Its subtree is cut in O(1)
+	 * time, the children left behind are then paired up as in pop().
+	 */
+	void erase(reference elem)
+	{
+		pairing_heap_node* node = member_of(&elem, NodeMember);
+
+		if (node == _root) {
+			pop();
+			return;
+		}
+
+		cut(node);
+		_root = meld(_root, merge_pairs(node->child));
+		node->child = nullptr;
+		--_size;
+	}
+
+	/**
+	 * Restore the heap order after \a elem moved towards the top, that is,
+	 * after it came to compare less than before.
+	 */
+	void decrease(reference elem)
+	{
+		pairing_heap_node* node = member_of(&elem, NodeMember);
+
+		if (node == _root)
+			return;
+
+		cut(node);
+		_root = meld(_root, node);
+	}
+
+	/**
+	 * Restore the heap order after \a elem changed in any direction.
+	 */
+	void update(reference elem)
+	{
+		erase(elem);
+		push(elem);
+	}
+
+	/**
+	 * Move every element of \a other into this heap.
+	 */
+	void merge(pairing_heap& other)
+	{
+		_root = meld(_root, other._root);
+		_size += other._size;
+		other._root = nullptr;
+		other._size = 0;
+	}
+
+	/**
+	 * Forget every element in O(1), their hooks are reset by push().
+	 */
+	void clear()
+	{
+		_root = nullptr;
+		_size = 0;
+	}
+
+	bool empty() const
+	{
+		return !_root;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	void swap(pairing_heap& other)
+	{
+		std::swap(_root, other._root);
+		std::swap(_size, other._size);
+	}
+
+private:
+	//
+	// Unlink the subtree rooted at node from its parent and siblings
+	//
+	static void cut(pairing_heap_node* node)
+	{
+		if (node->prev->child == node)
+			node->prev->child = node->next;
+		else
+			node->prev->next = node->next;
+
+		if (node->next)
+			node->next->prev = node->prev;
+
+		node->next = nullptr;
+		node->prev = nullptr;
+	}
+
+	//
+	// Link two heaps, the root that compares greater becomes the first child
+	// of the other
+	//
+	static pairing_heap_node* meld(pairing_heap_node* a, pairing_heap_node* b)
+	{
+		Compare cmp;
+
+		if (!a)
+			return b;
+		if (!b)
+			return a;
+
+		if (cmp(*parent_of(b, NodeMember), *parent_of(a, NodeMember)))
+			std::swap(a, b);
+
+		b->next = a->child;
+		if (a->child)
+			a->child->prev = b;
+		b->prev = a;
+		a->child = b;
+
+		return a;
+	}
+
+	//
+	// Two pass pairing of the siblings starting at first: meld them in pairs
+	// from left to right, then meld the pairs from right to left. The pairs
+	// are kept in a stack linked through next in between.
+	//
+	static pairing_heap_node* merge_pairs(pairing_heap_node* first)
+	{
+		pairing_heap_node* stack = nullptr;
+
+		while (first) {
+			pairing_heap_node* a = first;
+			pairing_heap_node* b = a->next;
+
+			first = b ? b->next : nullptr;
+
+			a->next = nullptr;
+			a->prev = nullptr;
+			if (b) {
+				b->next = nullptr;
+				b->prev = nullptr;
+				a = meld(a, b);
+			}
+
+			a->next = stack;
+			stack = a;
+		}
+
+		if (!stack)
+			return nullptr;
+
+		pairing_heap_node* root = stack;
+
+		stack = root->next;
+		root->next = nullptr;
+		while (stack) {
+			pairing_heap_node* node = stack;
+
+			stack = node->next;
+			node->next = nullptr;
+			root = meld(root, node);
+		}
+
+		return root;
+	}
+
+private:
+	pairing_heap_node* _root;
+	size_t             _size;
+};
+
+template<class T, pairing_heap_node T::* NodeMember, class Compare>
+inline void swap(pairing_heap<T, NodeMember, Compare>& rhs, pairing_heap<T, NodeMember, Compare>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_PAIRING_HEAP__HPP_ */
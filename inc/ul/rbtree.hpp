@@ -13,17 +13,284 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 #include <ul/base.hpp>
+#include <ul/executor.hpp>
 #include <ul/rbtree_node.hpp>
 #include <ul/rbtree_iterator.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace ul {
 
 ///////////////////////////////////////////////////////////////////////////////
-template<class T, rbtree_node T::* NodeMember, class Compare = std::less<T> >
+/**
+ * \brief Default augmentation policy, nodes keep no data besides their links.
+ *
+ * An augmentation policy keeps, in each element, data that depends on the
+ * element's subtree, and provides:
+ * - update(elem, left, right): recompute the data of \a elem from the one of
+ *   its children, returning false if it was left unchanged;
+ * - copy(from, to): copy the data of \a from into \a to.
+ *
+ * Policies that aggregate a per element value also provide value_type,
+ * value(elem), subtree(elem) and combine(a, b), used by range queries.
+ */
+struct rbtree_no_augment { };
+
+/**
+ * \brief Augmentation policy that keeps the number of elements of each
+ *        subtree in \a CountMember, enabling rank and select in O(log n).
+ */
+template<class T, size_t T::* CountMember>
+struct rbtree_counter {
+	typedef size_t value_type;
+
+	static bool update(T& elem, T const* left, T const* right)
+	{
+		size_t count = 1 + (left ? left->*CountMember : 0) + (right ? right->*CountMember : 0);
+
+		if (elem.*CountMember == count)
+			return false;
+
+		elem.*CountMember = count;
+		return true;
+	}
+
+	static void copy(T const& from, T& to)
+	{
+		to.*CountMember = from.*CountMember;
+	}
+
+	static size_t count(T const& elem)
+	{
+		return elem.*CountMember;
+	}
+
+	static value_type value(T const&)             { return 1; }
+	static value_type subtree(T const& elem)      { return elem.*CountMember; }
+	static value_type combine(size_t a, size_t b) { return a + b; }
+};
+
+/**
+ * \brief Augmentation policy that folds \a ValueMember over each subtree
+ *        into \a AggregateMember using \a Combine, e.g. std::plus for sums,
+ *        std::bit_or for mask unions or a max functor.
+ *
+ * \a Combine must be associative, subtrees are folded in key order.
+ */
+template<class T, class V, V T::* ValueMember, V T::* AggregateMember, class Combine = std::plus<V> >
+struct rbtree_aggregate {
+	typedef V value_type;
+
+	static bool update(T& elem, T const* left, T const* right)
+	{
+		V aggregate = elem.*ValueMember;
+
+		if (left)
+			aggregate = combine(left->*AggregateMember, aggregate);
+		if (right)
+			aggregate = combine(aggregate, right->*AggregateMember);
+
+		if (elem.*AggregateMember == aggregate)
+			return false;
+
+		elem.*AggregateMember = aggregate;
+		return true;
+	}
+
+	static void copy(T const& from, T& to)
+	{
+		to.*AggregateMember = from.*AggregateMember;
+	}
+
+	static value_type value(T const& elem)   { return elem.*ValueMember; }
+	static value_type subtree(T const& elem) { return elem.*AggregateMember; }
+
+	static value_type combine(V const& a, V const& b)
+	{
+		return Combine()(a, b);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+template<class Compare>
+struct rbtree_is_transparent {
+	template<class C> static char test(typename C::is_transparent*);
+	template<class C> static long test(...);
+
+	static const bool value = sizeof(test<Compare>(nullptr)) == sizeof(char);
+};
+
+//
+// Lookups by key use Compare when it is transparent, that is, when it
+// declares is_transparent and compares keys of any type against elements.
+// Otherwise keys must provide the operators key < elem and key > elem.
+//
+template<class T, class Compare, bool Transparent = rbtree_is_transparent<Compare>::value>
+struct rbtree_key_compare {
+	template<class Key>
+	static bool key_less(Compare const& cmp, Key const& key, T const& elem) { return cmp(key, elem); }
+
+	template<class Key>
+	static bool elem_less(Compare const& cmp, T const& elem, Key const& key) { return cmp(elem, key); }
+};
+
+template<class T, class Compare>
+struct rbtree_key_compare<T, Compare, false> {
+	static bool key_less(Compare const& cmp, T const& key, T const& elem)  { return cmp(key, elem); }
+	static bool elem_less(Compare const& cmp, T const& elem, T const& key) { return cmp(elem, key); }
+
+	template<class Key>
+	static bool key_less(Compare const&, Key const& key, T const& elem) { return key < elem; }
+
+	template<class Key>
+	static bool elem_less(Compare const&, T const& elem, Key const& key) { return key > elem; }
+};
+
+template<class Augment>
+struct rbtree_has_count {
+	template<class A> static char test(decltype(&A::count));
+	template<class A> static long test(...);
+
+	static const bool value = sizeof(test<Augment>(nullptr)) == sizeof(char);
+};
+
+//
+// Number of nodes of a tree, taken from the root when subtrees are counted
+//
+template<class T, rbtree_node T::* NodeMember, class Augment, bool Counted = rbtree_has_count<Augment>::value>
+struct rbtree_size_of {
+	static size_t size(rbtree_node* root)
+	{
+		return root ? Augment::count(*parent_of(root, NodeMember)) : 0;
+	}
+};
+
+template<class T, rbtree_node T::* NodeMember, class Augment>
+struct rbtree_size_of<T, NodeMember, Augment, false> {
+	static size_t size(rbtree_node* root)
+	{
+		size_t n = 0;
+
+		if (root) {
+			for (rbtree_node* node = root->min(); node; node = node->next())
+				++n;
+		}
+		return n;
+	}
+};
+
+template<class T, rbtree_node T::* NodeMember, class Augment>
+struct rbtree_augment_ops {
+	static bool update(rbtree_node* node)
+	{
+		return Augment::update(*parent_of(node, NodeMember),
+		                       parent_of(node->left, NodeMember),
+		                       parent_of(node->right, NodeMember));
+	}
+
+	static void propagate(rbtree_node* node, rbtree_node* stop)
+	{
+		while (node != stop && update(node))
+			node = node->parent();
+	}
+
+	static void copy(rbtree_node* from, rbtree_node* to)
+	{
+		Augment::copy(*parent_of(from, NodeMember), *parent_of(to, NodeMember));
+	}
+
+	static void rotate(rbtree_node* from, rbtree_node* to)
+	{
+		copy(from, to);
+		update(from);
+	}
+
+	static void insert(rbtree_node* node, rbtree_node** root, rbtree_node* parent)
+	{
+		node->insert(root, parent, callbacks);
+	}
+
+	static void remove(rbtree_node* node, rbtree_node** root)
+	{
+		node->remove(root, callbacks);
+	}
+
+	static rbtree_node* join(rbtree_node* left, rbtree_node* pivot, rbtree_node* right)
+	{
+		return rbtree_node::join(left, pivot, right, callbacks);
+	}
+
+	static rbtree_node* join(rbtree_node* left, uint left_height, rbtree_node* pivot,
+	                         rbtree_node* right, uint right_height, uint& height)
+	{
+		return rbtree_node::join(left, left_height, pivot, right, right_height, height, callbacks);
+	}
+
+	static size_t size(rbtree_node* root)
+	{
+		return rbtree_size_of<T, NodeMember, Augment>::size(root);
+	}
+
+	static rbtree_augment const callbacks;
+};
+
+template<class T, rbtree_node T::* NodeMember, class Augment>
+rbtree_augment const rbtree_augment_ops<T, NodeMember, Augment>::callbacks = {
+	&rbtree_augment_ops::propagate,
+	&rbtree_augment_ops::copy,
+	&rbtree_augment_ops::rotate
+};
+
+template<class T, rbtree_node T::* NodeMember>
+struct rbtree_augment_ops<T, NodeMember, rbtree_no_augment> {
+	static bool update(rbtree_node*)
+	{
+		return false;
+	}
+
+	static void propagate(rbtree_node*, rbtree_node*)
+	{ }
+
+	static void copy(rbtree_node*, rbtree_node*)
+	{ }
+
+	static void insert(rbtree_node* node, rbtree_node** root, rbtree_node* parent)
+	{
+		node->insert(root, parent);
+	}
+
+	static void remove(rbtree_node* node, rbtree_node** root)
+	{
+		node->remove(root);
+	}
+
+	static rbtree_node* join(rbtree_node* left, rbtree_node* pivot, rbtree_node* right)
+	{
+		return rbtree_node::join(left, pivot, right);
+	}
+
+	static rbtree_node* join(rbtree_node* left, uint left_height, rbtree_node* pivot,
+	                         rbtree_node* right, uint right_height, uint& height)
+	{
+		return rbtree_node::join(left, left_height, pivot, right, right_height, height);
+	}
+
+	static size_t size(rbtree_node* root)
+	{
+		return rbtree_size_of<T, NodeMember, rbtree_no_augment>::size(root);
+	}
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, rbtree_node T::* NodeMember, class Compare = std::less<T>, class Augment = rbtree_no_augment>
 class rbtree {
 	rbtree(const rbtree&);
 	rbtree& operator=(const rbtree&);
@@ -37,9 +304,10 @@ public:
 	typedef rbtree_iterator<T const, NodeMember>  const_iterator;
 	typedef std::reverse_iterator<iterator>       reverse_iterator;
 	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+	typedef Augment                               augment_type;
 
 	rbtree()
-		: _root(nullptr)
+		: _root(nullptr), _leftmost(nullptr), _rightmost(nullptr), _size(0)
 	{ }
 
 	iterator insert_equal(reference elem)
@@ -56,10 +324,7 @@ public:
 			else
 				next = &(*next)->right;
 		}
-		*next = node;
-		node->insert(&_root, parent);
-
-		return iterator(node);
+		return link(node, parent, next);
 	}
 
 	std::pair<iterator, bool> insert_unique(reference elem)
@@ -78,10 +343,61 @@ public:
 			else
 				return std::pair<iterator, bool>(iterator(*next), false);
 		}
-		*next = node;
-		node->insert(&_root, parent);
+		return std::pair<iterator, bool>(link(node, parent, next), true);
+	}
+
+	/**
+	 * Insert \a elem as close as possible before \a hint, in amortized O(1)
+	 * when \a elem belongs right before it.
+	 */
+	iterator insert_equal(iterator hint, reference elem)
+	{
+		rbtree_node* prev;
+		rbtree_node* next = hint_node(hint, prev);
+		Compare      cmp;
+
+		if ((!next || !cmp(*parent_of(next, NodeMember), elem))
+		 && (!prev || !cmp(elem, *parent_of(prev, NodeMember))))
+			return link_between(member_of(&elem, NodeMember), prev, next);
+
+		return insert_equal(elem);
+	}
+
+	std::pair<iterator, bool> insert_unique(iterator hint, reference elem)
+	{
+		rbtree_node* prev;
+		rbtree_node* next = hint_node(hint, prev);
+		Compare      cmp;
+
+		if ((!next || cmp(elem, *parent_of(next, NodeMember)))
+		 && (!prev || cmp(*parent_of(prev, NodeMember), elem)))
+			return std::pair<iterator, bool>(link_between(member_of(&elem, NodeMember), prev, next), true);
 
-		return std::pair<iterator, bool>(iterator(node), true);
+		return insert_unique(elem);
+	}
+
+	/**
+	 * Link the elements of the sorted range [first, last) into an empty tree
+	 * as a perfectly balanced tree, in O(n) and without any rotation.
+	 */
+	template<class Iterator>
+	void assign_sorted(Iterator first, Iterator last)
+	{
+		UL_ASSERT(empty());
+
+		size_t n = std::distance(first, last);
+		if (!n)
+			return;
+
+		uint depth = 0;
+		for (size_t i = n; i > 1; i >>= 1)
+			++depth;
+
+		rbtree_node* root = build_sorted(first, n, 0, depth);
+
+		root->parent(nullptr);
+		root->color(rbtree_node::black);
+		reset(root, n);
 	}
 
 	template<class Key>
@@ -104,6 +420,78 @@ public:
 		return const_iterator(n);
 	}
 
+	/**
+	 * Look up the \a n keys at \a keys, storing in \a out the iterator to a
+	 * matching element or end() for each of them.
+	 *
+	 * Several descents run interleaved, each one prefetching its next node
+	 * before yielding to the others, so that the cache misses of independent
+	 * lookups overlap instead of being paid one after the other.
+	 */
+	template<class Key>
+	void find_many(Key const* keys, size_t n, iterator* out)
+	{
+		find_many_impl(keys, n, out);
+	}
+
+	template<class Key>
+	void find_many(Key const* keys, size_t n, const_iterator* out) const
+	{
+		find_many_impl(keys, n, out);
+	}
+
+	template<class Key>
+	iterator lower_bound(Key const& key)
+	{
+		return make_iterator(lower_bound_impl(key, _root, nullptr));
+	}
+
+	template<class Key>
+	const_iterator lower_bound(Key const& key) const
+	{
+		return make_iterator(lower_bound_impl(key, _root, nullptr));
+	}
+
+	template<class Key>
+	iterator upper_bound(Key const& key)
+	{
+		return make_iterator(upper_bound_impl(key, _root, nullptr));
+	}
+
+	template<class Key>
+	const_iterator upper_bound(Key const& key) const
+	{
+		return make_iterator(upper_bound_impl(key, _root, nullptr));
+	}
+
+	template<class Key>
+	std::pair<iterator, iterator> equal_range(Key const& key)
+	{
+		std::pair<rbtree_node*, rbtree_node*> r = equal_range_impl(key);
+
+		return std::pair<iterator, iterator>(make_iterator(r.first), make_iterator(r.second));
+	}
+
+	template<class Key>
+	std::pair<const_iterator, const_iterator> equal_range(Key const& key) const
+	{
+		std::pair<rbtree_node*, rbtree_node*> r = equal_range_impl(key);
+
+		return std::pair<const_iterator, const_iterator>(make_iterator(r.first), make_iterator(r.second));
+	}
+
+	template<class Key>
+	size_t count(Key const& key) const
+	{
+		std::pair<rbtree_node*, rbtree_node*> r = equal_range_impl(key);
+		size_t                                n = 0;
+
+		for (rbtree_node* i = r.first; i != r.second; i = i->next())
+			++n;
+
+		return n;
+	}
+
 	void remove(iterator i)
 	{
 		remove(*i);
@@ -111,7 +499,7 @@ public:
 
 	void remove(reference elem)
 	{
-		member_of(&elem, NodeMember)->remove(&_root);
+		unlink(member_of(&elem, NodeMember));
 	}
 
 	template<class Key>
@@ -121,73 +509,537 @@ public:
 		if (!n)
 			return false;
 
-		n->remove(&_root);
+		unlink(n);
 		return true;
 	}
 
+	/**
+	 * Recompute the augmented data after \a elem was changed in place, the
+	 * change must not affect the element's position in the tree.
+	 */
+	void update(reference elem)
+	{
+		augment_ops::propagate(member_of(&elem, NodeMember), nullptr);
+	}
+
+	void update(iterator i)
+	{
+		update(*i);
+	}
+
+	/**
+	 * Make this tree, which must be empty or be one of the arguments, hold
+	 * the elements of \a left, \a pivot and the elements of \a right, in
+	 * this order. Takes O(log n) time and leaves \a left and \a right empty.
+	 */
+	void join(rbtree& left, reference pivot, rbtree& right)
+	{
+		rbtree_node* node      = member_of(&pivot, NodeMember);
+		rbtree_node* leftmost  = left._root ? left._leftmost : node;
+		rbtree_node* rightmost = right._root ? right._rightmost : node;
+		size_t       size      = add_size(add_size(left.stored_size(), 1), right.stored_size());
+		rbtree_node* l         = left._root;
+		rbtree_node* r         = right._root;
+
+		left.reset(nullptr, 0);
+		right.reset(nullptr, 0);
+		UL_ASSERT(empty());
+
+		_root = augment_ops::join(l, node, r);
+		_leftmost = leftmost;
+		_rightmost = rightmost;
+		_size.store(size, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Append the elements of \a right, none of which may be ordered before
+	 * the elements of this tree, in O(log n) time.
+	 */
+	void join(rbtree& right)
+	{
+		if (right.empty())
+			return;
+
+		rbtree_node* pivot = right._leftmost;
+		rbtree_node* root  = right._root;
+
+		_leftmost = _root ? _leftmost : pivot;
+		_rightmost = right._rightmost;
+		_size.store(add_size(stored_size(), right.stored_size()), std::memory_order_relaxed);
+		right.reset(nullptr, 0);
+
+		augment_ops::remove(pivot, &root);
+		_root = augment_ops::join(_root, pivot, root);
+	}
+
+	/**
+	 * Move the elements not ordered before \a key to \a right, which must be
+	 * empty, in O(log n) time. Without an rbtree_counter augmentation both
+	 * trees count their elements on the next call to size().
+	 */
+	template<class Key>
+	void split(Key const& key, rbtree& right)
+	{
+		subtree r;
+		size_t  size = stored_size();
+
+		UL_ASSERT(right.empty());
+
+		subtree l = split_impl(tree_of(_root), key, r, nullptr);
+
+		if (detail::rbtree_has_count<Augment>::value) {
+			size_t n = augment_ops::size(l.root);
+
+			reset(l.root, n);
+			right.reset(r.root, size - n);
+		} else {
+			reset(l.root, k_unknown_size);
+			right.reset(r.root, k_unknown_size);
+		}
+	}
+
+	/**
+	 * Set union, elements of \a other not found in this tree are moved into
+	 * it, the remaining ones are handed to \a disposer. Both trees must hold
+	 * unique keys, \a other is left empty.
+	 *
+	 * The join based algorithms split the problem in two independent halves
+	 * at each level, which \a executor may run in parallel through its
+	 * fork(f, g) member. In that case \a disposer must be thread safe.
+	 *
+	 * Compare must not throw, neither here nor in intersect() and subtract():
+	 * a branch running on another thread would terminate the process, and
+	 * on the calling thread the tree would be left partly split.
+	 */
+	template<class Disposer, class Executor>
+	void unite(rbtree& other, Disposer disposer, Executor& executor)
+	{
+		subtree a        = tree_of(_root);
+		subtree b        = tree_of(other._root);
+		size_t  size     = add_size(stored_size(), other.stored_size());
+		size_t  disposed = 0;
+
+		other.reset(nullptr, 0);
+		a = unite_impl(a, b, disposed, disposer, executor, fork_levels(a));
+		reset(make_root(a.root), sub_size(size, disposed));
+	}
+
+	template<class Disposer>
+	void unite(rbtree& other, Disposer disposer)
+	{
+		sequential_executor executor;
+		unite(other, disposer, executor);
+	}
+
+	/**
+	 * Set intersection, elements of this tree not found in \a other are
+	 * handed to \a disposer, \a other is left unchanged.
+	 */
+	template<class Disposer, class Executor>
+	void intersect(rbtree const& other, Disposer disposer, Executor& executor)
+	{
+		subtree a        = tree_of(_root);
+		size_t  disposed = 0;
+
+		a = intersect_impl(a, other._root, disposed, disposer, executor, fork_levels(a));
+		reset(make_root(a.root), sub_size(stored_size(), disposed));
+	}
+
+	template<class Disposer>
+	void intersect(rbtree const& other, Disposer disposer)
+	{
+		sequential_executor executor;
+		intersect(other, disposer, executor);
+	}
+
+	/**
+	 * Set difference, elements of this tree found in \a other are handed to
+	 * \a disposer, \a other is left unchanged.
+	 */
+	template<class Disposer, class Executor>
+	void subtract(rbtree const& other, Disposer disposer, Executor& executor)
+	{
+		subtree a        = tree_of(_root);
+		size_t  disposed = 0;
+
+		a = subtract_impl(a, other._root, disposed, disposer, executor, fork_levels(a));
+		reset(make_root(a.root), sub_size(stored_size(), disposed));
+	}
+
+	template<class Disposer>
+	void subtract(rbtree const& other, Disposer disposer)
+	{
+		sequential_executor executor;
+		subtract(other, disposer, executor);
+	}
+
+	/**
+	 * Unlink every element, in O(n) and without rebalancing.
+	 */
+	void clear()
+	{
+		clear_and_dispose(null_disposer());
+	}
+
+	/**
+	 * Unlink every element in post-order, without rebalancing, handing each
+	 * one to \a disposer once it is unlinked. Takes O(n) time.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		rbtree_node* root = _root;
+
+		reset(nullptr, 0);
+		dispose_impl(root, disposer);
+	}
+
+	/**
+	 * Dispose of the elements of this tree and make it a copy of \a other,
+	 * with the same shape and colors, in O(n) time and without comparing
+	 * elements. \a cloner returns a new element from an element of
+	 * \a other. If it throws, the copies made so far are handed to
+	 * \a disposer and this tree is left empty. Cloning a tree from itself
+	 * leaves it unchanged.
+	 */
+	template<class Cloner, class Disposer>
+	void clone_from(rbtree const& other, Cloner cloner, Disposer disposer)
+	{
+		if (&other == this)
+			return;
+
+		clear_and_dispose(disposer);
+		if (!other._root)
+			return;
+
+		rbtree_node* src  = other._root;
+		rbtree_node* root = clone_node(src, nullptr, cloner);
+		rbtree_node* dst  = root;
+
+		try {
+			//
+			// Walk both trees in lockstep, a child that was not cloned yet
+			// is the next one to visit
+			//
+			for (;;) {
+				if (src->left && !dst->left) {
+					dst->left = clone_node(src->left, dst, cloner);
+					src = src->left;
+					dst = dst->left;
+				} else if (src->right && !dst->right) {
+					dst->right = clone_node(src->right, dst, cloner);
+					src = src->right;
+					dst = dst->right;
+				} else if (src != other._root) {
+					src = src->parent();
+					dst = dst->parent();
+				} else {
+					break;
+				}
+			}
+		} catch (...) {
+			dispose_impl(root, disposer);
+			throw;
+		}
+
+		reset(root, other.size());
+	}
+
 	bool empty() const
 	{
 		return !_root;
 	}
 
+	/**
+	 * Number of elements, in O(1) except for the first call after a split
+	 * of a tree without an rbtree_counter augmentation, which counts them.
+	 * Concurrent calls on a tree that is not modified are safe.
+	 */
+	size_t size() const
+	{
+		size_t n = stored_size();
+
+		if (n == k_unknown_size) {
+			n = augment_ops::size(_root);
+			_size.store(n, std::memory_order_relaxed);
+		}
+
+		return n;
+	}
+
+	//
+	// Order statistics, requires an rbtree_counter augmentation policy
+	//
+
+	iterator nth(size_t n)
+	{
+		rbtree_node* node = nth_impl(n);
+		if (!node)
+			return end();
+
+		return iterator(node);
+	}
+
+	const_iterator nth(size_t n) const
+	{
+		rbtree_node* node = nth_impl(n);
+		if (!node)
+			return end();
+
+		return const_iterator(node);
+	}
+
+	size_t rank(iterator i) const
+	{
+		return rank(*i);
+	}
+
+	size_t rank(const_reference elem) const
+	{
+		rbtree_node* node = member_of(const_cast<pointer>(&elem), NodeMember);
+		size_t       n    = subtree_count(node->left);
+
+		for (rbtree_node* parent; (parent = node->parent()); node = parent) {
+			if (node == parent->right)
+				n += subtree_count(parent->left) + 1;
+		}
+
+		return n;
+	}
+
+	//
+	// Range aggregates, requires an augmentation policy that provides combine
+	//
+	template<class Key, class V>
+	V accumulate_below(Key const& key, V init) const
+	{
+		rbtree_node* next = _root;
+		Compare      cmp;
+
+		while (next) {
+			T const& elem = *parent_of(next, NodeMember);
+
+			if (key_compare::elem_less(cmp, elem, key)) {
+				if (next->left)
+					init = Augment::combine(init, Augment::subtree(*parent_of(next->left, NodeMember)));
+				init = Augment::combine(init, Augment::value(elem));
+				next = next->right;
+			} else {
+				next = next->left;
+			}
+		}
+
+		return init;
+	}
+
 	void swap(rbtree& other)
 	{
 		std::swap(_root, other._root);
-	}
+		std::swap(_leftmost, other._leftmost);
+		std::swap(_rightmost, other._rightmost);
+		size_t size = stored_size();
 
+		_size.store(other.stored_size(), std::memory_order_relaxed);
+		other._size.store(size, std::memory_order_relaxed);
+	}
 
+	//
+	// The first and last nodes are cached, the end iterator is the last node
+	// tagged as out of range
+	//
 	iterator begin()
 	{
-		return _root ? iterator(_root->min()) : iterator();
+		return iterator(_leftmost);
 	}
 
 	iterator end()
 	{
-		return _root ? iterator(_root->max(), rbtree_out_of_range_tag()) : iterator();
+		return _rightmost ? iterator(_rightmost, rbtree_out_of_range_tag()) : iterator();
 	}
 
 	const_iterator begin() const
 	{
-		return _root ? const_iterator(_root->min()) : const_iterator();
+		return const_iterator(_leftmost);
 	}
 
 	const_iterator end() const
 	{
-		return _root ? const_iterator(_root->max(), rbtree_out_of_range_tag()) : const_iterator();
+		return _rightmost ? const_iterator(_rightmost, rbtree_out_of_range_tag()) : const_iterator();
 	}
 
 	reverse_iterator rbegin()
 	{
-		return _root ? reverse_iterator(iterator(_root->max())) : reverse_iterator();
+		return reverse_iterator(end());
 	}
 
 	reverse_iterator rend()
 	{
-		return _root ? reverse_iterator(iterator(_root->min(), rbtree_out_of_range_tag()))
-		             : reverse_iterator();
+		return reverse_iterator(begin());
 	}
 
 	const_reverse_iterator rbegin() const
 	{
-		return _root ? const_reverse_iterator(const_iterator(_root->max())) : const_reverse_iterator();
+		return const_reverse_iterator(end());
 	}
 
 	const_reverse_iterator rend() const
 	{
-		return _root ? const_reverse_iterator(const_iterator(_root->min(), rbtree_out_of_range_tag()))
-		             : const_reverse_iterator();
+		return const_reverse_iterator(begin());
 	}
 
 private:
+	typedef detail::rbtree_augment_ops<T, NodeMember, Augment> augment_ops;
+	typedef detail::rbtree_key_compare<T, Compare>             key_compare;
+
+	static size_t subtree_count(rbtree_node* node)
+	{
+		return node ? Augment::count(*parent_of(node, NodeMember)) : 0;
+	}
+
+	rbtree_node* nth_impl(size_t n) const
+	{
+		rbtree_node* next = _root;
+
+		while (next) {
+			size_t left = subtree_count(next->left);
+
+			if (n < left) {
+				next = next->left;
+			} else if (n > left) {
+				n -= left + 1;
+				next = next->right;
+			} else {
+				return next;
+			}
+		}
+
+		return nullptr;
+	}
+
+	//
+	// Nodes between which an element is inserted given a hint
+	//
+	rbtree_node* hint_node(iterator hint, rbtree_node*& prev) const
+	{
+		rbtree_node* next = hint.node();
+
+		if (!next || hint.out_of_range()) {
+			prev = _rightmost;
+			next = nullptr;
+		} else {
+			prev = next->prev();
+		}
+
+		return next;
+	}
+
+	iterator link_between(rbtree_node* node, rbtree_node* prev, rbtree_node* next)
+	{
+		if (next && !next->left)
+			return link(node, next, &next->left);
+
+		if (prev) {
+			UL_ASSERT(!prev->right);
+			return link(node, prev, &prev->right);
+		}
+
+		UL_ASSERT(!_root);
+		return link(node, nullptr, &_root);
+	}
+
+	iterator link(rbtree_node* node, rbtree_node* parent, rbtree_node** next)
+	{
+		if (!parent) {
+			_leftmost = node;
+			_rightmost = node;
+		} else if (next == &parent->left) {
+			if (parent == _leftmost)
+				_leftmost = node;
+		} else {
+			if (parent == _rightmost)
+				_rightmost = node;
+		}
+
+		*next = node;
+		augment_ops::insert(node, &_root, parent);
+		_size.store(add_size(stored_size(), 1), std::memory_order_relaxed);
+
+		return iterator(node);
+	}
+
+	void unlink(rbtree_node* node)
+	{
+		if (node == _leftmost)
+			_leftmost = node->next();
+		if (node == _rightmost)
+			_rightmost = node->prev();
+
+		augment_ops::remove(node, &_root);
+		_size.store(sub_size(stored_size(), 1), std::memory_order_relaxed);
+	}
+
+	void reset(rbtree_node* root, size_t size)
+	{
+		_root = root;
+		_leftmost = root ? root->min() : nullptr;
+		_rightmost = root ? root->max() : nullptr;
+		_size.store(size, std::memory_order_relaxed);
+	}
+
+	//
+	// The count may be unknown after a split, until size() is called. As
+	// const callers may store it concurrently it is kept in an atomic, all
+	// of them storing the same value.
+	//
+	size_t stored_size() const
+	{
+		return _size.load(std::memory_order_relaxed);
+	}
+
+	static size_t add_size(size_t a, size_t b)
+	{
+		return (a == k_unknown_size || b == k_unknown_size) ? k_unknown_size : a + b;
+	}
+
+	static size_t sub_size(size_t a, size_t b)
+	{
+		return a == k_unknown_size ? k_unknown_size : a - b;
+	}
+
+	//
+	// Nodes at red_depth are colored red, the tree is complete above it
+	//
+	template<class Iterator>
+	static rbtree_node* build_sorted(Iterator& first, size_t n, uint depth, uint red_depth)
+	{
+		size_t       left = (n - 1) / 2;
+		rbtree_node* prev = left ? build_sorted(first, left, depth + 1, red_depth) : nullptr;
+		rbtree_node* node = member_of(&*first, NodeMember);
+
+		++first;
+		node->left = prev;
+		node->right = (n - 1 - left) ? build_sorted(first, n - 1 - left, depth + 1, red_depth) : nullptr;
+
+		node->color(depth == red_depth ? rbtree_node::red : rbtree_node::black);
+		if (node->left)
+			node->left->parent(node);
+		if (node->right)
+			node->right->parent(node);
+		augment_ops::update(node);
+
+		return node;
+	}
+
 	template<class Key>
 	rbtree_node* find_impl(Key const& key) const
 	{
 		rbtree_node* next = _root;
+		Compare      cmp;
 
 		while (next) {
-			if (key < *parent_of(next, NodeMember))
+			if (key_compare::key_less(cmp, key, *parent_of(next, NodeMember)))
 				next = next->left;
-			else if (key > *parent_of(next, NodeMember))
+			else if (key_compare::elem_less(cmp, *parent_of(next, NodeMember), key))
 				next = next->right;
 			else
 				return next;
@@ -196,12 +1048,484 @@ private:
 		return nullptr;
 	}
 
+	//
+	// Batched lookups, up to k_find_many_lanes descents are in flight and
+	// each finished one is replaced by the next pending key
+	//
+	static const uint k_find_many_lanes = 16;
+
+	template<class Key, class Iterator>
+	void find_many_impl(Key const* keys, size_t n, Iterator* out) const
+	{
+		struct lane {
+			rbtree_node* node;
+			size_t       index;
+		};
+
+		lane     lanes[k_find_many_lanes];
+		Iterator last    = _rightmost ? Iterator(_rightmost, rbtree_out_of_range_tag()) : Iterator();
+		uint     active  = 0;
+		size_t   pending = 0;
+		Compare  cmp;
+
+		for (; active < k_find_many_lanes && pending < n; ++active, ++pending) {
+			lanes[active].node = _root;
+			lanes[active].index = pending;
+		}
+
+		while (active) {
+			for (uint i = 0; i < active;) {
+				lane&        l     = lanes[i];
+				Key const&   key   = keys[l.index];
+				rbtree_node* node  = l.node;
+				bool         found = false;
+
+				if (node) {
+					T const& elem = *parent_of(node, NodeMember);
+
+					if (key_compare::key_less(cmp, key, elem))
+						node = node->left;
+					else if (key_compare::elem_less(cmp, elem, key))
+						node = node->right;
+					else
+						found = true;
+				}
+
+				if (found) {
+					out[l.index] = Iterator(l.node);
+				} else if (node) {
+					UL_PREFETCH(node);
+					UL_PREFETCH(parent_of(node, NodeMember));
+					l.node = node;
+					++i;
+					continue;
+				} else {
+					out[l.index] = last;
+				}
+
+				//
+				// Lookup done, start the next one on this lane or retire it
+				//
+				if (pending < n) {
+					l.node = _root;
+					l.index = pending++;
+					++i;
+				} else {
+					l = lanes[--active];
+				}
+			}
+		}
+	}
+
+	//
+	// First node not less than key in the subtree rooted at next, or bound
+	//
+	template<class Key>
+	static rbtree_node* lower_bound_impl(Key const& key, rbtree_node* next, rbtree_node* bound)
+	{
+		Compare cmp;
+
+		while (next) {
+			if (key_compare::elem_less(cmp, *parent_of(next, NodeMember), key)) {
+				next = next->right;
+			} else {
+				bound = next;
+				next = next->left;
+			}
+		}
+
+		return bound;
+	}
+
+	//
+	// First node greater than key in the subtree rooted at next, or bound
+	//
+	template<class Key>
+	static rbtree_node* upper_bound_impl(Key const& key, rbtree_node* next, rbtree_node* bound)
+	{
+		Compare cmp;
+
+		while (next) {
+			if (key_compare::key_less(cmp, key, *parent_of(next, NodeMember))) {
+				bound = next;
+				next = next->left;
+			} else {
+				next = next->right;
+			}
+		}
+
+		return bound;
+	}
+
+	template<class Key>
+	std::pair<rbtree_node*, rbtree_node*> equal_range_impl(Key const& key) const
+	{
+		rbtree_node* next  = _root;
+		rbtree_node* bound = nullptr;
+		Compare      cmp;
+
+		//
+		// Descend until the first equivalent node, both bounds are found below it
+		//
+		while (next) {
+			if (key_compare::key_less(cmp, key, *parent_of(next, NodeMember))) {
+				bound = next;
+				next = next->left;
+			} else if (key_compare::elem_less(cmp, *parent_of(next, NodeMember), key)) {
+				next = next->right;
+			} else {
+				return std::pair<rbtree_node*, rbtree_node*>(lower_bound_impl(key, next->left, next),
+				                                             upper_bound_impl(key, next->right, bound));
+			}
+		}
+
+		return std::pair<rbtree_node*, rbtree_node*>(bound, bound);
+	}
+
+	//
+	// A detached subtree along with its black height, counting its root as
+	// black as joining it makes it. Keeping track of the heights spares the
+	// joins from measuring them.
+	//
+	struct subtree {
+		rbtree_node* root;
+		uint         height;
+	};
+
+	static subtree tree_of(rbtree_node* root)
+	{
+		subtree t = { root, rbtree_node::black_height(root) };
+		return t;
+	}
+
+	//
+	// Height of a child of a node of the given height. The child is one black
+	// node down whatever the color of its parent, unless it is red itself.
+	//
+	static uint child_height(uint height, rbtree_node* child)
+	{
+		return child ? height - 1 + (child->color() == rbtree_node::red) : 0;
+	}
+
+	//
+	// Height of the parent of a node of the given height, as the node was
+	// colored before being joined
+	//
+	static uint parent_height(uint height, rbtree_node* node)
+	{
+		return height - (node->color() == rbtree_node::red) + 1;
+	}
+
+	static subtree child_of(uint height, rbtree_node* child)
+	{
+		subtree t = { detach(child), child_height(height, child) };
+		return t;
+	}
+
+	static subtree join_impl(subtree left, rbtree_node* pivot, subtree right)
+	{
+		subtree t;
+
+		t.root = augment_ops::join(left.root, left.height, pivot, right.root, right.height, t.height);
+		return t;
+	}
+
+	//
+	// Split tree, returning the nodes ordered before key
+	// and the others in right. When match is given, an equivalent node is
+	// returned in it instead of going to either side.
+	//
+	template<class Key>
+	static subtree split_impl(subtree tree, Key const& key, subtree& right, rbtree_node** match)
+	{
+		rbtree_node* next   = tree.root;
+		rbtree_node* last   = nullptr;
+		uint         height = tree.height;
+		subtree      l      = { nullptr, 0 };
+		subtree      r      = { nullptr, 0 };
+		Compare      cmp;
+
+		if (match)
+			*match = nullptr;
+
+		//
+		// The height tracked is the one of the subtree at next, or at last
+		// once the walk falls off the tree
+		//
+		while (next) {
+			if (key_compare::elem_less(cmp, *parent_of(next, NodeMember), key)) {
+				last = next;
+				next = next->right;
+			} else if (match && !key_compare::key_less(cmp, key, *parent_of(next, NodeMember))) {
+				*match = next;
+				last = next->parent();
+				l = child_of(height, next->left);
+				r = child_of(height, next->right);
+				height = parent_height(height, next);
+				break;
+			} else {
+				last = next;
+				next = next->left;
+			}
+
+			if (next)
+				height = child_height(height, next);
+		}
+
+		//
+		// Walk back up joining every node with its subtree that is off the
+		// path into the side it belongs to
+		//
+		for (next = last; next; next = last) {
+			uint above = parent_height(height, next);
+
+			last = next->parent();
+
+			if (key_compare::elem_less(cmp, *parent_of(next, NodeMember), key))
+				l = join_impl(child_of(height, next->left), next, l);
+			else
+				r = join_impl(r, next, child_of(height, next->right));
+
+			height = above;
+		}
+
+		right = r;
+		return l;
+	}
+
+	//
+	// Join two trees without a pivot. Taking one out of the right tree may
+	// lower its height, measuring it again costs no more than the removal.
+	//
+	static subtree join_impl(subtree left, subtree right)
+	{
+		if (!left.root)
+			return right;
+		if (!right.root)
+			return left;
+
+		rbtree_node* pivot = right.root->min();
+
+		make_root(right.root);
+		augment_ops::remove(pivot, &right.root);
+		return join_impl(left, pivot, tree_of(right.root));
+	}
+
+	template<class Disposer>
+	static size_t dispose_impl(rbtree_node* node, Disposer& disposer)
+	{
+		rbtree_node* parent;
+		size_t       n = 0;
+
+		//
+		// Post-order walk unlinking each node from its parent as it goes
+		//
+		while (node) {
+			if (node->left) {
+				node = node->left;
+			} else if (node->right) {
+				node = node->right;
+			} else {
+				parent = node->parent();
+				if (parent) {
+					if (parent->left == node)
+						parent->left = nullptr;
+					else
+						parent->right = nullptr;
+				}
+				dispose_node(node, disposer);
+				node = parent;
+				++n;
+			}
+		}
+
+		return n;
+	}
+
+	struct null_disposer {
+		void operator()(pointer) const { }
+	};
+
+	template<class Cloner>
+	static rbtree_node* clone_node(rbtree_node* src, rbtree_node* parent, Cloner& cloner)
+	{
+		rbtree_node* node = member_of(cloner(*parent_of(src, NodeMember)), NodeMember);
+
+		node->parent(parent);
+		node->color(src->color());
+		node->left = nullptr;
+		node->right = nullptr;
+		augment_ops::copy(src, node);
+
+		return node;
+	}
+
+	template<class Disposer>
+	static void dispose_node(rbtree_node* node, Disposer& disposer)
+	{
+		node->parent(nullptr);
+		node->left = nullptr;
+		node->right = nullptr;
+		disposer(parent_of(node, NodeMember));
+	}
+
+	static rbtree_node* make_root(rbtree_node* node)
+	{
+		if (node)
+			node->color(rbtree_node::black);
+
+		return node;
+	}
+
+	//
+	// Recursion levels of the set algorithms at which the executor is asked
+	// to fork, subtrees below them are too small to be worth it
+	//
+	static uint fork_levels(subtree const& tree)
+	{
+		static const uint k_grain = 12;
+
+		return tree.height > k_grain ? tree.height - k_grain : 0;
+	}
+
+	template<class F, class G, class Executor>
+	static void fork(F const& f, G const& g, Executor& executor, uint levels)
+	{
+		if (levels) {
+			executor.fork(f, g);
+		} else {
+			f();
+			g();
+		}
+	}
+
+	//
+	// The set algorithms add the number of elements they dispose of to
+	// disposed, each branch of a fork counting its own
+	//
+	template<class Disposer, class Executor>
+	static subtree unite_impl(subtree a, subtree b, size_t& disposed,
+	                          Disposer& disposer, Executor& executor, uint levels)
+	{
+		if (!a.root)
+			return b;
+		if (!b.root)
+			return a;
+
+		subtree      al = child_of(a.height, a.root->left);
+		subtree      ar = child_of(a.height, a.root->right);
+		subtree      bl;
+		subtree      br;
+		rbtree_node* match;
+
+		bl = split_impl(b, *parent_of(a.root, NodeMember), br, &match);
+		if (match) {
+			dispose_node(match, disposer);
+			++disposed;
+		}
+
+		uint   next = levels ? levels - 1 : 0;
+		size_t dl   = 0;
+		size_t dr   = 0;
+
+		fork([&] { al = unite_impl(al, bl, dl, disposer, executor, next); },
+		     [&] { ar = unite_impl(ar, br, dr, disposer, executor, next); },
+		     executor, levels);
+
+		disposed += dl + dr;
+		return join_impl(al, a.root, ar);
+	}
+
+	template<class Disposer, class Executor>
+	static subtree intersect_impl(subtree a, rbtree_node* b, size_t& disposed,
+	                              Disposer& disposer, Executor& executor, uint levels)
+	{
+		if (!a.root)
+			return a;
+
+		if (!b) {
+			subtree t = { nullptr, 0 };
+
+			disposed += dispose_impl(a.root, disposer);
+			return t;
+		}
+
+		subtree      al;
+		subtree      ar;
+		rbtree_node* match;
+
+		al = split_impl(a, *parent_of(b, NodeMember), ar, &match);
+
+		uint   next = levels ? levels - 1 : 0;
+		size_t dl   = 0;
+		size_t dr   = 0;
+
+		fork([&] { al = intersect_impl(al, b->left, dl, disposer, executor, next); },
+		     [&] { ar = intersect_impl(ar, b->right, dr, disposer, executor, next); },
+		     executor, levels);
+
+		disposed += dl + dr;
+		return match ? join_impl(al, match, ar) : join_impl(al, ar);
+	}
+
+	template<class Disposer, class Executor>
+	static subtree subtract_impl(subtree a, rbtree_node* b, size_t& disposed,
+	                             Disposer& disposer, Executor& executor, uint levels)
+	{
+		if (!a.root || !b)
+			return a;
+
+		subtree      al;
+		subtree      ar;
+		rbtree_node* match;
+
+		al = split_impl(a, *parent_of(b, NodeMember), ar, &match);
+		if (match) {
+			dispose_node(match, disposer);
+			++disposed;
+		}
+
+		uint   next = levels ? levels - 1 : 0;
+		size_t dl   = 0;
+		size_t dr   = 0;
+
+		fork([&] { al = subtract_impl(al, b->left, dl, disposer, executor, next); },
+		     [&] { ar = subtract_impl(ar, b->right, dr, disposer, executor, next); },
+		     executor, levels);
+
+		disposed += dl + dr;
+		return join_impl(al, ar);
+	}
+
+	static rbtree_node* detach(rbtree_node* node)
+	{
+		if (node)
+			node->parent(nullptr);
+
+		return node;
+	}
+
+	iterator make_iterator(rbtree_node* node)
+	{
+		return node ? iterator(node) : end();
+	}
+
+	const_iterator make_iterator(rbtree_node* node) const
+	{
+		return node ? const_iterator(node) : end();
+	}
+
 private:
-	rbtree_node* _root;
+	static const size_t k_unknown_size = ~size_t(0);
+
+	rbtree_node*                _root;
+	rbtree_node*                _leftmost;
+	rbtree_node*                _rightmost;
+	mutable std::atomic<size_t> _size;
 };
 
-template<class T, rbtree_node T::* NodeMember>
-inline void swap(rbtree<T, NodeMember>& rhs, rbtree<T, NodeMember>& lhs)
+template<class T, rbtree_node T::* NodeMember, class Compare, class Augment>
+inline void swap(rbtree<T, NodeMember, Compare, Augment>& rhs, rbtree<T, NodeMember, Compare, Augment>& lhs)
 {
 	rhs.swap(lhs);
 }
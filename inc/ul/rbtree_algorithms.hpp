@@ -0,0 +1,315 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_RBTREE_ALGORITHMS__HPP_
+#define UL_RBTREE_ALGORITHMS__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/debug.hpp>
+#include <ul/rbtree_node.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Red-black tree balancing over node handles other than pointers, the
+ *        same algorithms rbtree_node implements for its own links.
+ *
+ * Traits is an object that maps a node handle to its links:
+ * - node_ptr:                    handle type
+ * - null():                      the handle of no node
+ * - parent(n), parent(n, p):     parent link
+ * - left(n), left(n, l):         left child link
+ * - right(n), right(n, r):       right child link
+ * - color(n), color(n, c):       node color, a rbtree_node::color_type
+ */
+template<class Traits>
+struct rbtree_algorithms {
+	typedef typename Traits::node_ptr node_ptr;
+
+	static node_ptr min(Traits const& t, node_ptr node)
+	{
+		for (node_ptr next; (next = t.left(node)) != t.null();)
+			node = next;
+		return node;
+	}
+
+	static node_ptr max(Traits const& t, node_ptr node)
+	{
+		for (node_ptr next; (next = t.right(node)) != t.null();)
+			node = next;
+		return node;
+	}
+
+	static node_ptr next(Traits const& t, node_ptr node)
+	{
+		if (t.right(node) != t.null())
+			return min(t, t.right(node));
+
+		node_ptr parent = t.parent(node);
+		while (parent != t.null() && node == t.right(parent)) {
+			node = parent;
+			parent = t.parent(node);
+		}
+		return parent;
+	}
+
+	static node_ptr prev(Traits const& t, node_ptr node)
+	{
+		if (t.left(node) != t.null())
+			return max(t, t.left(node));
+
+		node_ptr parent = t.parent(node);
+		while (parent != t.null() && node == t.left(parent)) {
+			node = parent;
+			parent = t.parent(node);
+		}
+		return parent;
+	}
+
+	/**
+	 * Link \a node as the left or right child of \a parent, or as the root
+	 * when \a parent is null, and rebalance.
+	 */
+	static void insert(Traits const& t, node_ptr& root, node_ptr node, node_ptr parent, bool left)
+	{
+		t.parent(node, parent);
+		t.left(node, t.null());
+		t.right(node, t.null());
+		t.color(node, rbtree_node::red);
+
+		if (parent == t.null())
+			root = node;
+		else if (left)
+			t.left(parent, node);
+		else
+			t.right(parent, node);
+
+		insert_color(t, root, node);
+	}
+
+	static void erase(Traits const& t, node_ptr& root, node_ptr old)
+	{
+		node_ptr                child;
+		node_ptr                parent;
+		rbtree_node::color_type color;
+
+		if (t.left(old) != t.null() && t.right(old) != t.null()) {
+			//
+			// The successor, which has no left child, takes the place of
+			// the removed node
+			//
+			node_ptr node = min(t, t.right(old));
+
+			child = t.right(node);
+			parent = t.parent(node);
+			color = t.color(node);
+
+			if (child != t.null())
+				t.parent(child, parent);
+
+			if (parent == old) {
+				t.right(parent, child);
+				parent = node;
+			} else {
+				t.left(parent, child);
+			}
+
+			t.color(node, t.color(old));
+			t.parent(node, t.parent(old));
+			t.left(node, t.left(old));
+			t.right(node, t.right(old));
+			replace_child(t, root, old, node);
+
+			t.parent(t.left(old), node);
+			if (t.right(old) != t.null())
+				t.parent(t.right(old), node);
+		} else {
+			child = t.left(old) != t.null() ? t.left(old) : t.right(old);
+			parent = t.parent(old);
+			color = t.color(old);
+
+			if (child != t.null())
+				t.parent(child, parent);
+			replace_child(t, root, old, child);
+		}
+
+		if (color == rbtree_node::black)
+			remove_color(t, root, child, parent);
+
+		t.parent(old, t.null());
+		t.left(old, t.null());
+		t.right(old, t.null());
+	}
+
+private:
+	static bool is_black(Traits const& t, node_ptr node)
+	{
+		return node == t.null() || t.color(node) == rbtree_node::black;
+	}
+
+	static void replace_child(Traits const& t, node_ptr& root, node_ptr old, node_ptr node)
+	{
+		node_ptr parent = t.parent(old);
+
+		if (parent == t.null())
+			root = node;
+		else if (t.left(parent) == old)
+			t.left(parent, node);
+		else
+			t.right(parent, node);
+	}
+
+	static void rotate_left(Traits const& t, node_ptr& root, node_ptr node)
+	{
+		node_ptr tmp = t.right(node);
+
+		t.right(node, t.left(tmp));
+		if (t.left(tmp) != t.null())
+			t.parent(t.left(tmp), node);
+		t.left(tmp, node);
+
+		t.parent(tmp, t.parent(node));
+		replace_child(t, root, node, tmp);
+		t.parent(node, tmp);
+	}
+
+	static void rotate_right(Traits const& t, node_ptr& root, node_ptr node)
+	{
+		node_ptr tmp = t.left(node);
+
+		t.left(node, t.right(tmp));
+		if (t.right(tmp) != t.null())
+			t.parent(t.right(tmp), node);
+		t.right(tmp, node);
+
+		t.parent(tmp, t.parent(node));
+		replace_child(t, root, node, tmp);
+		t.parent(node, tmp);
+	}
+
+	static void insert_color(Traits const& t, node_ptr& root, node_ptr node)
+	{
+		for (;;) {
+			node_ptr parent = t.parent(node);
+
+			if (parent == t.null()) {
+				t.color(node, rbtree_node::black);
+				return;
+			}
+			if (t.color(parent) == rbtree_node::black)
+				return;
+
+			node_ptr grandparent = t.parent(parent);
+			node_ptr uncle       = parent == t.left(grandparent) ? t.right(grandparent) : t.left(grandparent);
+
+			if (!is_black(t, uncle)) {
+				t.color(parent, rbtree_node::black);
+				t.color(uncle, rbtree_node::black);
+				t.color(grandparent, rbtree_node::red);
+				node = grandparent;
+				continue;
+			}
+
+			if (parent == t.left(grandparent)) {
+				if (node == t.right(parent)) {
+					rotate_left(t, root, parent);
+					parent = node;
+				}
+				t.color(parent, rbtree_node::black);
+				t.color(grandparent, rbtree_node::red);
+				rotate_right(t, root, grandparent);
+			} else {
+				if (node == t.left(parent)) {
+					rotate_right(t, root, parent);
+					parent = node;
+				}
+				t.color(parent, rbtree_node::black);
+				t.color(grandparent, rbtree_node::red);
+				rotate_left(t, root, grandparent);
+			}
+			return;
+		}
+	}
+
+	static void remove_color(Traits const& t, node_ptr& root, node_ptr node, node_ptr parent)
+	{
+		node_ptr sibling;
+
+		while (parent != t.null() && is_black(t, node)) {
+			if (node == t.left(parent)) {
+				sibling = t.right(parent);
+				if (t.color(sibling) == rbtree_node::red) {
+					t.color(sibling, rbtree_node::black);
+					t.color(parent, rbtree_node::red);
+					rotate_left(t, root, parent);
+					sibling = t.right(parent);
+				}
+
+				if (is_black(t, t.left(sibling)) && is_black(t, t.right(sibling))) {
+					t.color(sibling, rbtree_node::red);
+					node = parent;
+					parent = t.parent(node);
+					continue;
+				}
+
+				if (is_black(t, t.right(sibling))) {
+					t.color(t.left(sibling), rbtree_node::black);
+					t.color(sibling, rbtree_node::red);
+					rotate_right(t, root, sibling);
+					sibling = t.right(parent);
+				}
+				t.color(sibling, t.color(parent));
+				t.color(parent, rbtree_node::black);
+				t.color(t.right(sibling), rbtree_node::black);
+				rotate_left(t, root, parent);
+			} else {
+				sibling = t.left(parent);
+				if (t.color(sibling) == rbtree_node::red) {
+					t.color(sibling, rbtree_node::black);
+					t.color(parent, rbtree_node::red);
+					rotate_right(t, root, parent);
+					sibling = t.left(parent);
+				}
+
+				if (is_black(t, t.left(sibling)) && is_black(t, t.right(sibling))) {
+					t.color(sibling, rbtree_node::red);
+					node = parent;
+					parent = t.parent(node);
+					continue;
+				}
+
+				if (is_black(t, t.left(sibling))) {
+					t.color(t.right(sibling), rbtree_node::black);
+					t.color(sibling, rbtree_node::red);
+					rotate_left(t, root, sibling);
+					sibling = t.left(parent);
+				}
+				t.color(sibling, t.color(parent));
+				t.color(parent, rbtree_node::black);
+				t.color(t.left(sibling), rbtree_node::black);
+				rotate_right(t, root, parent);
+			}
+			node = root;
+			break;
+		}
+
+		if (node != t.null())
+			t.color(node, rbtree_node::black);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_RBTREE_ALGORITHMS__HPP_ */
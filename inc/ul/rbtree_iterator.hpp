@@ -43,6 +43,9 @@ public:
 		: _node(node)
 	{ _iptr |= k_out_of_range_bit; }
 
+	rbtree_node* node() const         { return reinterpret_cast<rbtree_node*>(_iptr & ~k_out_of_range_bit); }
+	bool         out_of_range() const { return _iptr & k_out_of_range_bit; }
+
 private:
 	void increment()
 	{
@@ -57,9 +60,16 @@ private:
 
 	void decrement()
 	{
-		rbtree_node* tmp = reinterpret_cast<rbtree_node*>(_iptr & ~k_out_of_range_bit);
-
-		tmp = tmp->next();
+		//
+		// The end iterator is tagged on the last node, stepping back from it
+		// just clears the tag
+		//
+		if (_iptr & k_out_of_range_bit) {
+			_iptr &= ~k_out_of_range_bit;
+			return;
+		}
+
+		rbtree_node* tmp = _node->prev();
 		if (tmp)
 			_node = tmp;
 		else
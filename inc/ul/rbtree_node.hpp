@@ -14,11 +14,14 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include <ul/base.hpp>
 #include <ul/debug.hpp>
+#include <atomic>
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace ul {
 
 ///////////////////////////////////////////////////////////////////////////////
+struct rbtree_augment;
+
 /**
  * \brief A raw reb-black binary tree node class to support custom
  *        implementations of algorithms based on balanced binary tree.
@@ -32,6 +35,42 @@ struct rbtree_node {
 	void insert(rbtree_node** root, rbtree_node* parent);
 	void remove(rbtree_node** root);
 
+	void insert(rbtree_node** root, rbtree_node* parent, rbtree_augment const& augment);
+	void remove(rbtree_node** root, rbtree_augment const& augment);
+
+	/**
+	 * Link the node at \a link, below \a parent, and rebalance. The node is
+	 * initialized before it is published, so lockless readers never see it
+	 * half linked.
+	 */
+	void insert(rbtree_node** root, rbtree_node* parent, rbtree_node** link);
+
+	/**
+	 * Join the trees rooted at \a left and \a right, with \a pivot between
+	 * them, returning the new root. Takes O(log n) time.
+	 */
+	static rbtree_node* join(rbtree_node* left, rbtree_node* pivot, rbtree_node* right);
+	static rbtree_node* join(rbtree_node* left, rbtree_node* pivot, rbtree_node* right,
+	                         rbtree_augment const& augment);
+
+	/**
+	 * Join given the black heights of both trees, as black_height() returns
+	 * them, storing the one of the new tree in \a height. Takes time in the
+	 * difference of the heights only, so a sequence of joins that keeps
+	 * track of them, as split does, telescopes to O(log n).
+	 */
+	static rbtree_node* join(rbtree_node* left, uint left_height, rbtree_node* pivot,
+	                         rbtree_node* right, uint right_height, uint& height);
+	static rbtree_node* join(rbtree_node* left, uint left_height, rbtree_node* pivot,
+	                         rbtree_node* right, uint right_height, uint& height,
+	                         rbtree_augment const& augment);
+
+	/**
+	 * Number of black nodes on a path down from \a root, counting it as
+	 * black, in O(log n) time.
+	 */
+	static uint black_height(rbtree_node const* root);
+
 	rbtree_node* max() const;
 	rbtree_node* min() const;
 	rbtree_node* next() const;
@@ -39,6 +78,34 @@ struct rbtree_node {
 	rbtree_node* root() const;
 
 
+	/**
+	 * Child and root links as seen by lockless readers. Every link rewritten
+	 * while inserting, removing or rebalancing is stored with release
+	 * semantics, in an order that never exposes a cycle to a reader walking
+	 * down from the root.
+	 */
+	static rbtree_node* load(rbtree_node* const& link)
+	{
+#if defined(__GNUC__)
+		return __atomic_load_n(&link, __ATOMIC_ACQUIRE);
+#else
+		rbtree_node* node = *static_cast<rbtree_node* const volatile*>(&link);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return node;
+#endif
+	}
+
+	static void store(rbtree_node*& link, rbtree_node* node)
+	{
+#if defined(__GNUC__)
+		__atomic_store_n(&link, node, __ATOMIC_RELEASE);
+#else
+		std::atomic_thread_fence(std::memory_order_release);
+		*static_cast<rbtree_node* volatile*>(&link) = node;
+#endif
+	}
+
+
 	enum color_type {
 		red   = 0,
 		black = 1
@@ -66,6 +133,19 @@ struct rbtree_node {
 		return static_cast<color_type>(_color);
 	}
 
+	/**
+	 * The two bits kept along the parent link, the color of red-black trees,
+	 * for other balancing schemes that link through this node.
+	 */
+	void bits(uint b)
+	{
+		_color = b;
+	}
+	uint bits() const
+	{
+		return _color;
+	}
+
 private:
 	union {
 		uintptr _parent;
@@ -77,6 +157,22 @@ public:
 	rbtree_node* right;
 };
 
+/**
+ * \brief Callbacks used to keep per node data, that depends on the node's
+ *        subtree, up to date while the tree is relinked and rebalanced.
+ *
+ * - propagate: recompute the data of \a node and its ancestors, stopping at
+ *              \a stop or as soon as a node's data is left unchanged.
+ * - copy:      \a to takes the place of \a from in the tree.
+ * - rotate:    \a to becomes the root of the subtree that was rooted at
+ *              \a from, which now is one of its children.
+ */
+struct rbtree_augment {
+	void (*propagate)(rbtree_node* node, rbtree_node* stop);
+	void (*copy)(rbtree_node* from, rbtree_node* to);
+	void (*rotate)(rbtree_node* from, rbtree_node* to);
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 } /* namespace ul */
 
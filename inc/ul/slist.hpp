@@ -0,0 +1,172 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_SLIST__HPP_
+#define UL_SLIST__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/slist_node.hpp>
+#include <ul/slist_iterator.hpp>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Singly linked list intrusive container, with a hook half the size
+ *        of list_node.
+ *
+ * The list keeps a pointer to its last element so push_back() and back()
+ * take O(1) time. Elements can only be inserted and erased after a given
+ * position, before_begin() being the position before the first one.
+ */
+template<class T, slist_node T::* NodeMember>
+class slist {
+	slist(const slist&);
+	slist& operator=(const slist&);
+
+public:
+	typedef T*                                  pointer;
+	typedef T const*                            const_pointer;
+	typedef T&                                  reference;
+	typedef T const&                            const_reference;
+	typedef slist_iterator<T, NodeMember>       iterator;
+	typedef slist_iterator<T const, NodeMember> const_iterator;
+
+public:
+	slist()
+		: _tail(&_root)
+	{ }
+
+
+	void push_front(reference elem)
+	{
+		slist_node* node = member_of(&elem, NodeMember);
+
+		if (_tail == &_root)
+			_tail = node;
+		_root.push_after(node);
+	}
+
+	void push_back(reference elem)
+	{
+		slist_node* node = member_of(&elem, NodeMember);
+
+		_tail->push_after(node);
+		_tail = node;
+	}
+
+	pointer pop_front()
+	{
+		if (_root.next == _tail)
+			_tail = &_root;
+		return parent_of(_root.pop_after(), NodeMember);
+	}
+
+	/**
+	 * Insert \a elem after the element at \a pos, returning its position.
+	 */
+	iterator insert_after(iterator pos, reference elem)
+	{
+		slist_node* node = member_of(&elem, NodeMember);
+
+		if (pos.node() == _tail)
+			_tail = node;
+		pos.node()->push_after(node);
+		return iterator(node);
+	}
+
+	/**
+	 * Unlink the element following \a pos, returning the position of the
+	 * one after it.
+	 */
+	iterator erase_after(iterator pos)
+	{
+		slist_node* prev = pos.node();
+
+		if (prev->next == _tail)
+			_tail = prev;
+		prev->pop_after();
+		return iterator(prev->next);
+	}
+
+	reference front() { return *parent_of(_root.next, NodeMember); }
+	reference back()  { return *parent_of(_tail, NodeMember); }
+
+	const_reference front() const { return *parent_of(_root.next, NodeMember); }
+	const_reference back() const  { return *parent_of(_tail, NodeMember); }
+
+	bool empty() const { return !_root.next; }
+
+	iterator before_begin() { return iterator(&_root); }
+	iterator begin()        { return iterator(_root.next); }
+	iterator end()          { return iterator(); }
+
+	const_iterator before_begin() const { return const_iterator(&_root); }
+	const_iterator begin() const        { return const_iterator(_root.next); }
+	const_iterator end() const          { return const_iterator(); }
+
+	void clear() { clear_and_dispose(null_disposer()); }
+
+	/**
+	 * Unlink every element, handing each one to \a disposer once unlinked.
+	 */
+	template<class Disposer>
+	void clear_and_dispose(Disposer disposer)
+	{
+		slist_node* node = _root.next;
+
+		_root.next = nullptr;
+		_tail = &_root;
+		while (node) {
+			slist_node* next = node->next;
+
+			node->next = nullptr;
+			disposer(parent_of(node, NodeMember));
+			node = next;
+		}
+	}
+
+	void swap(slist& l)
+	{
+		std::swap(_root.next, l._root.next);
+		std::swap(_tail, l._tail);
+
+		//
+		// An empty list points back at its own head
+		//
+		if (_tail == &l._root)
+			_tail = &_root;
+		if (l._tail == &_root)
+			l._tail = &l._root;
+	}
+
+private:
+	struct null_disposer {
+		void operator()(pointer) const { }
+	};
+
+	slist_node  _root;
+	slist_node* _tail;
+};
+
+template<class T, slist_node T::* NodeMember>
+inline void swap(slist<T, NodeMember>& rhs, slist<T, NodeMember>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_SLIST__HPP_ */
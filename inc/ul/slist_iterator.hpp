@@ -0,0 +1,57 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_SLIST_ITERATOR__HPP_
+#define UL_SLIST_ITERATOR__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/slist_node.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/mpl/if.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+template<class T, slist_node T::* NodeMember>
+class slist_iterator
+	: public boost::iterator_facade<slist_iterator<T, NodeMember>, T, boost::forward_traversal_tag> {
+
+	friend class boost::iterator_core_access;
+
+	typedef typename boost::mpl::if_<boost::is_const<T>, slist_node const, slist_node>::type node_type;
+
+public:
+	slist_iterator()
+		: _node(nullptr)
+	{ }
+	explicit slist_iterator(node_type* node)
+		: _node(const_cast<slist_node*>(node))
+	{ }
+
+	slist_node* node() const { return _node; }
+
+private:
+	void increment() { _node = _node->next; }
+
+	bool equal(slist_iterator const& other) const { return _node == other._node; }
+
+	T& dereference() const { return *parent_of(_node, NodeMember); }
+
+	slist_node* _node;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_SLIST_ITERATOR__HPP_ */
@@ -0,0 +1,56 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_SLIST_NODE__HPP_
+#define UL_SLIST_NODE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Defines a raw singly linked list hook, a single pointer to the next
+ *        node that is null at the end of the list.
+ */
+struct slist_node {
+	constexpr slist_node()
+		: next(nullptr)
+	{ }
+
+	slist_node(no_init_t)
+	{ }
+
+	void push_after(slist_node* node)
+	{
+		node->next = next;
+		next = node;
+	}
+
+	slist_node* pop_after()
+	{
+		slist_node* node = next;
+
+		next = node->next;
+		node->next = nullptr;
+		return node;
+	}
+
+
+	slist_node* next;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_SLIST_NODE__HPP_ */
@@ -0,0 +1,105 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_SPLAYTREE__HPP_
+#define UL_SPLAYTREE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/bstree.hpp>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+/**
+ * \brief Splay tree restructuring, every node inserted or looked up is
+ *        rotated up to the root.
+ */
+struct splaytree_algorithms : bstree_algorithms {
+	static void insert(rbtree_node** root, rbtree_node* node, rbtree_node* parent, rbtree_node** next)
+	{
+		bstree_algorithms::link(node, parent, next);
+		splay(root, node);
+	}
+
+	static void remove(rbtree_node** root, rbtree_node* old)
+	{
+		bool         left;
+		rbtree_node* parent = unlink(root, old, left);
+
+		if (parent)
+			splay(root, parent);
+	}
+
+	static void access(rbtree_node** root, rbtree_node* node)
+	{
+		splay(root, node);
+	}
+
+	/**
+	 * Bottom-up splay of \a node, each step halves, roughly, the depth of
+	 * the nodes along the path to the root.
+	 */
+	static void splay(rbtree_node** root, rbtree_node* node)
+	{
+		while (rbtree_node* parent = node->parent()) {
+			rbtree_node* grandparent = parent->parent();
+
+			if (grandparent) {
+				if ((grandparent->left == parent) == (parent->left == node))
+					rotate_up(root, parent);
+				else
+					rotate_up(root, node);
+			}
+			rotate_up(root, node);
+		}
+	}
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive splay tree, with the same hook and iterators as rbtree.
+ *
+ * Inserted elements, and those found by the non-const lookups, are moved to
+ * the root, so that recently used elements are the cheapest to find again.
+ * Operations take O(log n) amortized time, a single one may take O(n). The
+ * const lookups leave the tree as it is.
+ */
+template<class T, rbtree_node T::* NodeMember, class Compare = std::less<T> >
+class splaytree
+	: public detail::bstree<T, NodeMember, Compare, detail::splaytree_algorithms> {
+
+public:
+	/**
+	 * Move \a elem to the root.
+	 */
+	void splay(T& elem)
+	{
+		this->touch(elem);
+	}
+};
+
+template<class T, rbtree_node T::* NodeMember, class Compare>
+inline void swap(splaytree<T, NodeMember, Compare>& rhs, splaytree<T, NodeMember, Compare>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_SPLAYTREE__HPP_ */
@@ -0,0 +1,99 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_THREAD_EXECUTOR__HPP_
+#define UL_THREAD_EXECUTOR__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/executor.hpp>
+#include <boost/utility.hpp>
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Fork-join executor that runs the first branch on a new thread while
+ *        the calling thread runs the second one, as long as no more than
+ *        \a threads are busy. Otherwise both branches run on the caller.
+ *
+ * The first branch must not throw.
+ */
+class thread_executor : boost::noncopyable {
+public:
+	explicit thread_executor(uint threads = std::thread::hardware_concurrency())
+		: _idle(threads > 1 ? threads - 1 : 0)
+	{ }
+
+	template<class F, class G>
+	void fork(F const& f, G const& g)
+	{
+		if (!acquire()) {
+			f();
+			g();
+			return;
+		}
+
+		std::thread thread;
+
+		//
+		// Out of threads, the slot goes back and both branches run here
+		//
+		try {
+			thread = std::thread(f);
+		} catch (std::system_error const&) {
+			release();
+			f();
+			g();
+			return;
+		}
+
+		try {
+			g();
+
+		} catch (...) {
+			thread.join();
+			release();
+			throw;
+		}
+
+		thread.join();
+		release();
+	}
+
+private:
+	bool acquire()
+	{
+		int idle = _idle.load(std::memory_order_relaxed);
+
+		while (idle > 0) {
+			if (_idle.compare_exchange_weak(idle, idle - 1, std::memory_order_relaxed))
+				return true;
+		}
+		return false;
+	}
+
+	void release()
+	{
+		_idle.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::atomic<int> _idle;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_THREAD_EXECUTOR__HPP_ */
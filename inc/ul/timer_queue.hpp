@@ -0,0 +1,244 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_TIMER_QUEUE__HPP_
+#define UL_TIMER_QUEUE__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/exception.hpp>
+#include <ul/rbtree.hpp>
+#include <chrono>
+
+#if defined(__linux)
+#	include <sys/timerfd.h>
+#	include <cerrno>
+#	include <system_error>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Timer hook, the deadline of a scheduled element and its link into
+ *        the queue.
+ */
+class timer_node {
+	template<class T, timer_node T::* NodeMember>
+	friend class timer_queue;
+
+public:
+	typedef std::chrono::steady_clock clock;
+	typedef clock::time_point         time_point;
+
+	timer_node()
+		: _scheduled(false)
+	{ }
+
+	bool       scheduled() const { return _scheduled; }
+	time_point deadline() const  { return _deadline; }
+
+private:
+	struct deadline_less {
+		bool operator()(timer_node const& lhs, timer_node const& rhs) const { return lhs._deadline < rhs._deadline; }
+	};
+
+	rbtree_node _node;
+	time_point  _deadline;
+	bool        _scheduled;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive queue of timers ordered by deadline.
+ *
+ * schedule() and cancel() take O(log n) time, the earliest timer is cached
+ * so top() and next_deadline() take O(1). Timers with the same deadline
+ * expire in the order they were scheduled. Deadlines are on the steady
+ * clock, which on Linux is CLOCK_MONOTONIC.
+ */
+template<class T, timer_node T::* NodeMember>
+class timer_queue {
+	timer_queue(const timer_queue&);
+	timer_queue& operator=(const timer_queue&);
+
+	typedef rbtree<timer_node, &timer_node::_node, timer_node::deadline_less> tree_type;
+
+public:
+	typedef T*                     pointer;
+	typedef T&                     reference;
+	typedef T const&               const_reference;
+	typedef timer_node::clock      clock;
+	typedef timer_node::time_point time_point;
+
+	timer_queue()
+		: _armed(time_point::max())
+	{ }
+
+	/**
+	 * Schedule \a elem to expire at \a deadline, moving it if it was
+	 * already scheduled.
+	 */
+	void schedule(reference elem, time_point deadline)
+	{
+		timer_node* node = member_of(&elem, NodeMember);
+
+		if (node->_scheduled)
+			_tree.remove(*node);
+
+		node->_deadline = deadline;
+		node->_scheduled = true;
+		_tree.insert_equal(*node);
+	}
+
+	/**
+	 * Unschedule \a elem, returning false if it was not scheduled.
+	 */
+	bool cancel(reference elem)
+	{
+		timer_node* node = member_of(&elem, NodeMember);
+
+		if (!node->_scheduled)
+			return false;
+
+		_tree.remove(*node);
+		node->_scheduled = false;
+		return true;
+	}
+
+	/**
+	 * The timer with the earliest deadline, or null.
+	 */
+	pointer top() const
+	{
+		return _tree.empty() ? nullptr : parent_of(const_cast<timer_node*>(&*_tree.begin()), NodeMember);
+	}
+
+	/**
+	 * The earliest deadline, or time_point::max() when no timer is
+	 * scheduled.
+	 */
+	time_point next_deadline() const
+	{
+		return _tree.empty() ? time_point::max() : _tree.begin()->_deadline;
+	}
+
+	/**
+	 * Unschedule every timer whose deadline is not after \a now, in deadline
+	 * order, and hand it to \a callback. Returns the number of timers that
+	 * expired.
+	 *
+	 * The callback may schedule and cancel any timer, including the one it
+	 * was handed. Timers it schedules at or before \a now also expire in
+	 * this call.
+	 */
+	template<class Callback>
+	size_t expire_until(time_point now, Callback callback)
+	{
+		size_t n = 0;
+
+		//
+		// A timerfd armed for a deadline that passed went off and disarmed
+		// itself
+		//
+		if (!(now < _armed))
+			_armed = time_point::max();
+
+		while (!_tree.empty()) {
+			timer_node& node = *_tree.begin();
+
+			if (now < node._deadline)
+				break;
+
+			_tree.remove(node);
+			node._scheduled = false;
+			++n;
+			callback(*parent_of(&node, NodeMember));
+		}
+
+		return n;
+	}
+
+	bool empty() const
+	{
+		return _tree.empty();
+	}
+
+	size_t size() const
+	{
+		return _tree.size();
+	}
+
+#if defined(__linux)
+	/**
+	 * Arm \a fd, a timerfd created on CLOCK_MONOTONIC, to go off at the
+	 * earliest deadline, or disarm it when no timer is scheduled. The timer
+	 * is only reprogrammed when that deadline changed since the last call,
+	 * or went by according to expire_until().
+	 * Throws std::system_error when timerfd_settime() fails.
+	 */
+	void arm(int fd)
+	{
+		time_point deadline = next_deadline();
+
+		if (deadline == _armed)
+			return;
+
+		struct itimerspec its = { };
+
+		if (deadline != time_point::max()) {
+			sint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+
+			//
+			// An all zero value would disarm the timer
+			//
+			if (ns <= 0)
+				ns = 1;
+
+			its.it_value.tv_sec = ns / 1000000000;
+			its.it_value.tv_nsec = ns % 1000000000;
+		}
+
+		if (::timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, nullptr) < 0)
+			throw_exception(std::system_error(errno, std::system_category(), "timerfd_settime"));
+
+		_armed = deadline;
+	}
+#endif
+
+	void swap(timer_queue& other)
+	{
+		_tree.swap(other._tree);
+
+		//
+		// The timers armed stay with their queues, make the next arm() call
+		// on either one reprogram its own
+		//
+		_armed = time_point::max();
+		other._armed = time_point::max();
+	}
+
+private:
+	tree_type  _tree;
+	time_point _armed;
+};
+
+template<class T, timer_node T::* NodeMember>
+inline void swap(timer_queue<T, NodeMember>& rhs, timer_queue<T, NodeMember>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_TIMER_QUEUE__HPP_ */
@@ -0,0 +1,235 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_TIMING_WHEEL__HPP_
+#define UL_TIMING_WHEEL__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/list.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Timing wheel hook, the expiry tick of a scheduled element and its
+ *        link into a slot of the wheel.
+ */
+class timing_wheel_node {
+	template<class T, timing_wheel_node T::* NodeMember, uint Levels, uint SlotBits>
+	friend class timing_wheel;
+
+public:
+	timing_wheel_node()
+		: _expires(0)
+	{ }
+
+	bool   scheduled() const { return !_node.empty(); }
+	uint64 expires() const   { return _expires; }
+
+private:
+	list_node _node;
+	uint64    _expires;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Hierarchical timing wheel, timers are kept in \a Levels wheels of
+ *        2^SlotBits slots, each level counting ticks 2^SlotBits times
+ *        coarser than the one below.
+ *
+ * schedule() and cancel() take O(1) time. Timers further than the first
+ * level can tell apart are cascaded to lower levels as the wheel turns and
+ * expire on their exact tick. Timers further away than the whole wheel
+ * spans, 2^(Levels * SlotBits) ticks, wait in the last level until they
+ * come within range.
+ *
+ * Ticks are in whatever unit the caller advances the wheel by.
+ */
+template<class T, timing_wheel_node T::* NodeMember, uint Levels = 4, uint SlotBits = 8>
+class timing_wheel {
+	timing_wheel(const timing_wheel&);
+	timing_wheel& operator=(const timing_wheel&);
+
+	typedef list<timing_wheel_node, &timing_wheel_node::_node> slot_type;
+
+	static const uint   k_slots = 1u << SlotBits;
+	static const uint64 k_mask  = k_slots - 1;
+	static const uint64 k_span  = uint64(1) << (Levels * SlotBits);
+
+public:
+	typedef T*       pointer;
+	typedef T&       reference;
+	typedef T const& const_reference;
+
+	/**
+	 * Start the wheel at tick \a now.
+	 */
+	explicit timing_wheel(uint64 now = 0)
+		: _now(now), _size(0)
+	{ }
+
+	/**
+	 * Schedule \a elem to expire at tick \a expires, moving it if it was
+	 * already scheduled. Ticks already gone by expire on the next one.
+	 */
+	void schedule(reference elem, uint64 expires)
+	{
+		timing_wheel_node* node = member_of(&elem, NodeMember);
+
+		if (node->scheduled())
+			unlink(node);
+		else
+			++_size;
+
+		node->_expires = expires;
+		link(node);
+	}
+
+	/**
+	 * Unschedule \a elem, returning false if it was not scheduled.
+	 */
+	bool cancel(reference elem)
+	{
+		timing_wheel_node* node = member_of(&elem, NodeMember);
+
+		if (!node->scheduled())
+			return false;
+
+		unlink(node);
+		--_size;
+		return true;
+	}
+
+	/**
+	 * Turn the wheel through tick \a now, handing each timer that expires to
+	 * \a callback, and return their number.
+	 *
+	 * The callback may schedule and cancel any timer. Timers it schedules at
+	 * or before the tick being processed expire on the next one.
+	 */
+	template<class Callback>
+	size_t advance(uint64 now, Callback callback)
+	{
+		size_t n = 0;
+
+		while (_now <= now) {
+			if (!_size) {
+				_now = now + 1;
+				break;
+			}
+
+			if (!(_now & k_mask))
+				cascade();
+
+			slot_type work;
+
+			work.swap(_slots[0][_now & k_mask]);
+			++_now;
+
+			try {
+				while (!work.empty()) {
+					timing_wheel_node* node = work.pop_front();
+
+					reset(node);
+					--_size;
+					++n;
+					callback(*parent_of(node, NodeMember));
+				}
+			} catch (...) {
+				//
+				// What is left expires on the next tick
+				//
+				while (!work.empty())
+					_slots[0][_now & k_mask].push_back(*work.pop_front());
+				throw;
+			}
+		}
+
+		return n;
+	}
+
+	/**
+	 * The next tick to be processed.
+	 */
+	uint64 now() const
+	{
+		return _now;
+	}
+
+	bool empty() const
+	{
+		return !_size;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+private:
+	void link(timing_wheel_node* node)
+	{
+		uint64 expires = node->_expires < _now ? _now : node->_expires;
+		uint64 delta   = expires - _now;
+		uint   level   = 0;
+
+		while (level + 1 < Levels && (delta >> (SlotBits * (level + 1))))
+			++level;
+
+		if (delta >= k_span)
+			expires = _now + k_span - 1;
+
+		_slots[level][(expires >> (SlotBits * level)) & k_mask].push_back(*node);
+	}
+
+	static void unlink(timing_wheel_node* node)
+	{
+		node->_node.unlink();
+		reset(node);
+	}
+
+	static void reset(timing_wheel_node* node)
+	{
+		node->_node.next = &node->_node;
+		node->_node.prev = &node->_node;
+	}
+
+	//
+	// Called as the first level wraps around: the current slot of each level
+	// above is moved down, until one of them did not wrap as well
+	//
+	void cascade()
+	{
+		for (uint level = 1; level < Levels; ++level) {
+			uint64    index = (_now >> (SlotBits * level)) & k_mask;
+			slot_type work;
+
+			work.swap(_slots[level][index]);
+			while (!work.empty())
+				link(work.pop_front());
+
+			if (index)
+				break;
+		}
+	}
+
+private:
+	uint64    _now;
+	size_t    _size;
+	slot_type _slots[Levels][k_slots];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_TIMING_WHEEL__HPP_ */
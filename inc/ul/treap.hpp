@@ -0,0 +1,97 @@
+//=============================================================================
+// UL - Utilities Library
+//
+// Copyright (C) 2006-2013 Bruno Santos <bsantos@cppdev.net>
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//=============================================================================
+
+#ifndef UL_TREAP__HPP_
+#define UL_TREAP__HPP_
+
+///////////////////////////////////////////////////////////////////////////////
+#include <ul/base.hpp>
+#include <ul/bstree.hpp>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+namespace detail {
+
+/**
+ * \brief Treap balancing, nodes are kept in heap order of a priority taken
+ *        from a hash of their address, so the hook needs no extra room.
+ */
+struct treap_algorithms : bstree_algorithms {
+	static void insert(rbtree_node** root, rbtree_node* node, rbtree_node* parent, rbtree_node** next)
+	{
+		bstree_algorithms::link(node, parent, next);
+
+		while (node->parent() && priority(node) > priority(node->parent()))
+			rotate_up(root, node);
+	}
+
+	static void remove(rbtree_node** root, rbtree_node* old)
+	{
+		//
+		// Rotate the node down, below the child of higher priority, until it
+		// has at most one child
+		//
+		while (old->left && old->right) {
+			if (priority(old->left) > priority(old->right))
+				rotate_up(root, old->left);
+			else
+				rotate_up(root, old->right);
+		}
+
+		bool left;
+		unlink(root, old, left);
+	}
+
+	static void access(rbtree_node**, rbtree_node*)
+	{ }
+
+	static uint64 priority(rbtree_node const* node)
+	{
+		uint64 x = reinterpret_cast<uintptr>(node);
+
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33;
+
+		return x;
+	}
+};
+
+} /* namespace detail */
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * \brief Intrusive treap, with the same hook and iterators as rbtree.
+ *
+ * The shape of the tree is that of a random binary search tree, its expected
+ * height is O(log n) as long as element addresses are not picked to defeat
+ * the hash. Updates do about one rotation on average.
+ */
+template<class T, rbtree_node T::* NodeMember, class Compare = std::less<T> >
+class treap
+	: public detail::bstree<T, NodeMember, Compare, detail::treap_algorithms> {
+};
+
+template<class T, rbtree_node T::* NodeMember, class Compare>
+inline void swap(treap<T, NodeMember, Compare>& rhs, treap<T, NodeMember, Compare>& lhs)
+{
+	rhs.swap(lhs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} /* namespace ul */
+
+// EOF ////////////////////////////////////////////////////////////////////////
+#endif /* UL_TREAP__HPP_ */
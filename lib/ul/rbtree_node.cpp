@@ -24,49 +24,91 @@
 #include <ul/rbtree_node.hpp>
 
 ///////////////////////////////////////////////////////////////////////////////
-static void rotate_left(ul::rbtree_node* node, ul::rbtree_node** root)
+namespace {
+
+struct no_augment {
+	void propagate(ul::rbtree_node*, ul::rbtree_node*) const { }
+	void copy(ul::rbtree_node*, ul::rbtree_node*) const      { }
+	void rotate(ul::rbtree_node*, ul::rbtree_node*) const    { }
+};
+
+struct callback_augment {
+	explicit callback_augment(ul::rbtree_augment const& cb)
+		: callbacks(cb)
+	{ }
+
+	void propagate(ul::rbtree_node* node, ul::rbtree_node* stop) const { callbacks.propagate(node, stop); }
+	void copy(ul::rbtree_node* from, ul::rbtree_node* to) const       { callbacks.copy(from, to); }
+	void rotate(ul::rbtree_node* from, ul::rbtree_node* to) const     { callbacks.rotate(from, to); }
+
+	ul::rbtree_augment const& callbacks;
+};
+
+} /* namespace */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Links are published with release stores, see rbtree_node::load. Rotations
+// first unhook the child being lifted, then hang the old subtree root below
+// it and only then link it in place, so readers may miss nodes while a
+// rotation is in progress but never loop.
+//
+static inline void publish(ul::rbtree_node*& link, ul::rbtree_node* node)
+{
+	ul::rbtree_node::store(link, node);
+}
+
+template<class Augment>
+static void rotate_left(ul::rbtree_node* node, ul::rbtree_node** root, Augment const& augment)
 {
 	ul::rbtree_node* tmp = node->right;
 
-	if ((node->right = tmp->left))
+	publish(node->right, tmp->left);
+	if (tmp->left)
 		tmp->left->parent(node);
-	tmp->left = node;
+	publish(tmp->left, node);
 
 	tmp->parent(node->parent());
 	if (tmp->parent()) {
 		if (node == node->parent()->left) {
-			node->parent()->left = tmp;
+			publish(node->parent()->left, tmp);
 		} else {
-			node->parent()->right = tmp;
+			publish(node->parent()->right, tmp);
 		}
 	} else {
-		*root = tmp;
+		publish(*root, tmp);
 	}
 	node->parent(tmp);
+	augment.rotate(node, tmp);
 }
 
-static void rotate_right(ul::rbtree_node* node, ul::rbtree_node** root)
+template<class Augment>
+static void rotate_right(ul::rbtree_node* node, ul::rbtree_node** root, Augment const& augment)
 {
 	ul::rbtree_node* tmp = node->left;
 
-	if ((node->left = tmp->right))
+	publish(node->left, tmp->right);
+	if (tmp->right)
 		tmp->right->parent(node);
-	tmp->right = node;
+	publish(tmp->right, node);
 
 	tmp->parent(node->parent());
 	if (tmp->parent()) {
 		if (node == node->parent()->right) {
-			node->parent()->right = tmp;
+			publish(node->parent()->right, tmp);
 		} else {
-			node->parent()->left = tmp;
+			publish(node->parent()->left, tmp);
 		}
 	} else {
-		*root = tmp;
+		publish(*root, tmp);
 	}
 	node->parent(tmp);
+	augment.rotate(node, tmp);
 }
 
-static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbtree_node** root)
+template<class Augment>
+static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbtree_node** root,
+                         Augment const& augment)
 {
 	ul::rbtree_node* sibling;
 
@@ -90,7 +132,7 @@ static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbt
 			if (sibling->color() == ul::rbtree_node::red) {
 				parent->color(ul::rbtree_node::red);
 				sibling->color(ul::rbtree_node::black);
-				rotate_left(parent, root);
+				rotate_left(parent, root, augment);
 				sibling = parent->right;
 			}
 
@@ -113,7 +155,7 @@ static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbt
 					} else {
 						sibling->color(ul::rbtree_node::red);
 						sibling->left->color(ul::rbtree_node::black);
-						rotate_right(sibling, root);
+						rotate_right(sibling, root, augment);
 						sibling = parent->right;
 					}
 				}
@@ -121,7 +163,7 @@ static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbt
 				parent->color(ul::rbtree_node::black);
 				if (sibling->right)
 					sibling->right->color(ul::rbtree_node::black);
-				rotate_left(parent, root);
+				rotate_left(parent, root, augment);
 			}
 
 		} else {
@@ -130,7 +172,7 @@ static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbt
 			if (sibling->color() == ul::rbtree_node::red) {
 				parent->color(ul::rbtree_node::red);
 				sibling->color(ul::rbtree_node::black);
-				rotate_right(parent, root);
+				rotate_right(parent, root, augment);
 				sibling = parent->left;
 			}
 
@@ -153,42 +195,39 @@ static void remove_color(ul::rbtree_node* node, ul::rbtree_node* parent, ul::rbt
 					} else {
 						sibling->color(ul::rbtree_node::red);
 						sibling->right->color(ul::rbtree_node::black);
-						rotate_left(sibling, root);
+						rotate_left(sibling, root, augment);
 						sibling = parent->left;
 					}
 				}
 				sibling->color(parent->color());
 				parent->color(ul::rbtree_node::black);
 				if (sibling->left) sibling->left->color(ul::rbtree_node::black);
-				rotate_right(parent, root);
+				rotate_right(parent, root, augment);
 			}
 		}
 		break;
 	}
 }
 
-///////////////////////////////////////////////////////////////////////////////
-namespace ul {
-
-///////////////////////////////////////////////////////////////////////////////
-void rbtree_node::insert(rbtree_node** root, rbtree_node* parent)
+//
+// Returns whether the black height of the tree grew, which happens only when
+// a red root is recolored
+//
+template<class Augment>
+static bool insert_color(ul::rbtree_node* node, ul::rbtree_node** root, Augment const& augment)
 {
-	rbtree_node* node = this;
+	using ul::rbtree_node;
+
 	rbtree_node* uncle;
 	rbtree_node* grandparent;
 
-	_parent = reinterpret_cast<uintptr>(parent);
-	_color = red;
-	left = nullptr;
-	right = nullptr;
-
 	for (;;) {
 		if (node->parent() == nullptr) {
-			node->color(black);
-			return;
+			node->color(rbtree_node::black);
+			return true;
 
-		} else if (node->parent()->color() == black) {
-			return;
+		} else if (node->parent()->color() == rbtree_node::black) {
+			return false;
 
 		} else {
 			grandparent = node->parent()->parent();
@@ -198,42 +237,45 @@ void rbtree_node::insert(rbtree_node** root, rbtree_node* parent)
 				uncle = grandparent->left;
 			}
 
-			if (uncle != nullptr && uncle->color() == red) {
-				node->color(red);
-				node->parent()->color(black);
-				uncle->color(black);
-				grandparent->color(red);
+			if (uncle != nullptr && uncle->color() == rbtree_node::red) {
+				node->color(rbtree_node::red);
+				node->parent()->color(rbtree_node::black);
+				uncle->color(rbtree_node::black);
+				grandparent->color(rbtree_node::red);
 				node = grandparent;
 				continue;
 
 			} else {
-				node->color(red);
+				node->color(rbtree_node::red);
 				if (node == node->parent()->right && node->parent() == grandparent->left) {
-					rotate_left(node->parent(), root);
+					rotate_left(node->parent(), root, augment);
 					node = node->left;
 
 				} else if (node == node->parent()->left && node->parent() == grandparent->right) {
-					rotate_right(node->parent(), root);
+					rotate_right(node->parent(), root, augment);
 					node = node->right;
 				}
 
-				node->parent()->color(black);
-				grandparent->color(red);
+				node->parent()->color(rbtree_node::black);
+				grandparent->color(rbtree_node::red);
 
 				if (node == node->parent()->left && node->parent() == grandparent->left) {
-					rotate_right(grandparent, root);
+					rotate_right(grandparent, root, augment);
 				} else {
-					rotate_left(grandparent, root);
+					rotate_left(grandparent, root, augment);
 				}
 			}
 		}
-		break;
+		return false;
 	}
 }
 
-void rbtree_node::remove(rbtree_node** root)
+template<class Augment>
+static void erase(ul::rbtree_node* old, ul::rbtree_node** root, Augment const& augment)
 {
-	rbtree_node* node = this;
+	using ul::rbtree_node;
+
+	rbtree_node* node = old;
 	rbtree_node* child;
 	rbtree_node* parent;
 	int color;
@@ -248,8 +290,6 @@ void rbtree_node::remove(rbtree_node** root)
 		child = node->left;
 
 	} else {
-		rbtree_node* old = node;
-
 		//
 		// Locate a node that satisfies the precondition to swap with the node to be removed
 		//
@@ -271,35 +311,48 @@ void rbtree_node::remove(rbtree_node** root)
 		if (child)
 			child->parent(parent);
 
+		//
+		// The successor is unhooked first and gets the children of the
+		// removed node before it is published in its place
+		//
 		if (parent == old) {
-			parent->right = child;
+			publish(parent->right, child);
 			parent = node;
 		} else {
-			parent->left = child;
+			publish(parent->left, child);
 		}
 
-		node->_parent = old->_parent;
-		node->left = old->left;
-		node->right = old->right;
+		node->color(old->color());
+		node->parent(old->parent());
+		publish(node->left, old->left);
+		publish(node->right, old->right);
 
 		if (old->parent()) {
 			UL_ASSERT((old->parent()->right == old) || (old->parent()->left == old));
 
 			if (old->parent()->left == old) {
-				old->parent()->left = node;
+				publish(old->parent()->left, node);
 
 			} else {
-				old->parent()->right = node;
+				publish(old->parent()->right, node);
 			}
 
 		} else {
-			*root = node;
+			publish(*root, node);
 		}
 
 		old->left->parent(node);
 		if (old->right)
 			old->right->parent(node);
 
+		//
+		// The successor lost a node below it and took the place of the removed one
+		//
+		augment.copy(old, node);
+		if (parent != node)
+			augment.propagate(parent, node);
+		augment.propagate(node, nullptr);
+
 		goto rm_color;
 	}
 
@@ -315,32 +368,208 @@ void rbtree_node::remove(rbtree_node** root)
 		UL_ASSERT((parent->right == node) || (parent->left == node));
 
 		if (parent->left == node) {
-			parent->left = child;
+			publish(parent->left, child);
 
 		} else {
-			parent->right = child;
+			publish(parent->right, child);
 		}
 
+		augment.propagate(parent, nullptr);
+
 	} else {
-		*root = child;
+		publish(*root, child);
 	}
 
 rm_color:
 	//
 	// Adjust Red-Black tree properties if node is black
 	//
-	if (color == black) {
-		remove_color(child, parent, root);
+	if (color == rbtree_node::black) {
+		remove_color(child, parent, root, augment);
 	}
 
-	UL_ASSERT(!*root || (*root)->color() == black);
+	UL_ASSERT(!*root || (*root)->color() == rbtree_node::black);
 
 	//
 	// Bug prevention
 	//
-	this->_parent = 0;
-	this->left = nullptr;
-	this->right = nullptr;
+	old->color(rbtree_node::red);
+	old->parent(nullptr);
+	publish(old->left, nullptr);
+	publish(old->right, nullptr);
+}
+
+//
+// The black heights given count the roots of both trees as black, as they are
+// recolored. Only the spine of the taller tree is walked, for as many levels
+// as the heights differ.
+//
+template<class Augment>
+static ul::rbtree_node* join(ul::rbtree_node* left, ul::uint lh, ul::rbtree_node* pivot,
+                             ul::rbtree_node* right, ul::uint rh, ul::uint& height,
+                             Augment const& augment)
+{
+	using ul::rbtree_node;
+
+	rbtree_node* root   = pivot;
+	rbtree_node* parent = nullptr;
+
+	//
+	// Both trees must be rooted at black nodes
+	//
+	if (left) {
+		UL_ASSERT(!left->parent());
+		left->color(rbtree_node::black);
+	}
+	if (right) {
+		UL_ASSERT(!right->parent());
+		right->color(rbtree_node::black);
+	}
+
+	if (lh > rh) {
+		//
+		// Descend the right spine of the left tree to a black node with the
+		// same black height as the right tree, the pivot takes its place
+		//
+		root = left;
+		height = lh;
+		while (left && (left->color() == rbtree_node::red || lh > rh)) {
+			if (left->color() == rbtree_node::black)
+				--lh;
+			parent = left;
+			left = left->right;
+		}
+		parent->right = pivot;
+		pivot->color(rbtree_node::red);
+
+	} else if (rh > lh) {
+		root = right;
+		height = rh;
+		while (right && (right->color() == rbtree_node::red || rh > lh)) {
+			if (right->color() == rbtree_node::black)
+				--rh;
+			parent = right;
+			right = right->left;
+		}
+		parent->left = pivot;
+		pivot->color(rbtree_node::red);
+
+	} else {
+		height = lh + 1;
+		pivot->color(rbtree_node::black);
+	}
+
+	pivot->parent(parent);
+	pivot->left = left;
+	pivot->right = right;
+	if (left)
+		left->parent(pivot);
+	if (right)
+		right->parent(pivot);
+
+	augment.propagate(pivot, parent);
+	if (parent) {
+		augment.propagate(parent, nullptr);
+		if (insert_color(pivot, &root, augment))
+			++height;
+	}
+
+	return root;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ul {
+
+///////////////////////////////////////////////////////////////////////////////
+void rbtree_node::insert(rbtree_node** root, rbtree_node* parent)
+{
+	_parent = reinterpret_cast<uintptr>(parent);
+	_color = red;
+	left = nullptr;
+	right = nullptr;
+
+	insert_color(this, root, no_augment());
+}
+
+void rbtree_node::insert(rbtree_node** root, rbtree_node* parent, rbtree_node** link)
+{
+	_parent = reinterpret_cast<uintptr>(parent);
+	_color = red;
+	publish(left, nullptr);
+	publish(right, nullptr);
+	publish(*link, this);
+
+	insert_color(this, root, no_augment());
+}
+
+void rbtree_node::insert(rbtree_node** root, rbtree_node* parent, rbtree_augment const& augment)
+{
+	_parent = reinterpret_cast<uintptr>(parent);
+	_color = red;
+	left = nullptr;
+	right = nullptr;
+
+	//
+	// Account for the new node before any rotation takes place
+	//
+	augment.propagate(this, parent);
+	if (parent)
+		augment.propagate(parent, nullptr);
+
+	insert_color(this, root, callback_augment(augment));
+}
+
+void rbtree_node::remove(rbtree_node** root)
+{
+	erase(this, root, no_augment());
+}
+
+void rbtree_node::remove(rbtree_node** root, rbtree_augment const& augment)
+{
+	erase(this, root, callback_augment(augment));
+}
+
+rbtree_node* rbtree_node::join(rbtree_node* left, rbtree_node* pivot, rbtree_node* right)
+{
+	uint height;
+
+	return ::join(left, black_height(left), pivot, right, black_height(right), height, no_augment());
+}
+
+rbtree_node* rbtree_node::join(rbtree_node* left, rbtree_node* pivot, rbtree_node* right,
+                               rbtree_augment const& augment)
+{
+	uint height;
+
+	return ::join(left, black_height(left), pivot, right, black_height(right), height,
+	              callback_augment(augment));
+}
+
+rbtree_node* rbtree_node::join(rbtree_node* left, uint left_height, rbtree_node* pivot,
+                               rbtree_node* right, uint right_height, uint& height)
+{
+	return ::join(left, left_height, pivot, right, right_height, height, no_augment());
+}
+
+rbtree_node* rbtree_node::join(rbtree_node* left, uint left_height, rbtree_node* pivot,
+                               rbtree_node* right, uint right_height, uint& height,
+                               rbtree_augment const& augment)
+{
+	return ::join(left, left_height, pivot, right, right_height, height, callback_augment(augment));
+}
+
+uint rbtree_node::black_height(rbtree_node const* root)
+{
+	if (!root)
+		return 0;
+
+	uint height = 1;
+
+	for (root = root->left; root; root = root->left) {
+		if (root->color() == black)
+			++height;
+	}
+	return height;
 }
 
 rbtree_node* rbtree_node::max() const
@@ -0,0 +1,32 @@
+#include <ul/atomic_stack.hpp>
+
+struct foo {
+	void bar() { }
+
+	ul::atomic_stack_node node;
+};
+
+struct disposer {
+	void operator()(foo*) const { }
+};
+
+int main()
+{
+	ul::atomic_stack<foo, &foo::node> stack;
+	ul::atomic_stack<foo, &foo::node> const& cstack = stack;
+	ul::atomic_stack<foo, &foo::node>::pointer p;
+	size_t n;
+	bool b;
+	foo x;
+	foo y(x);
+
+	stack.push(x);
+	stack.push(y);
+
+	p = stack.pop();
+	p->bar();
+	n = stack.pop_all(disposer());
+	b = cstack.empty();
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+#include <ul/btree.hpp>
+
+struct foo {
+	int key;
+};
+
+struct foo_key {
+	int operator()(foo const& f) const { return f.key; }
+};
+
+typedef ul::btree<foo, int, foo_key> tree_type;
+
+int main()
+{
+	tree_type tree;
+	tree_type stree;
+	tree_type const& ctree = tree;
+	tree_type::iterator i;
+	tree_type::const_iterator ci;
+	tree_type::reverse_iterator ri;
+	tree_type::const_reverse_iterator cri;
+	std::pair<tree_type::iterator, bool> ir;
+	size_t n;
+	bool b;
+	foo v = { 0 };
+
+	ir = tree.insert_unique(v);
+
+	i = tree.begin();
+	i = tree.end();
+	--i;
+	ri = tree.rbegin();
+	ri = tree.rend();
+	ci = ctree.begin();
+	ci = ctree.end();
+	cri = ctree.rbegin();
+	cri = ctree.rend();
+
+	i = tree.find(0);
+	ci = ctree.find(0);
+	i = tree.lower_bound(0);
+	ci = ctree.lower_bound(0);
+	i = tree.upper_bound(0);
+	ci = ctree.upper_bound(0);
+	n = ctree.count(i.key());
+
+	n = ctree.size();
+	b = ctree.empty();
+
+	tree.remove(i);
+	b = tree.remove(0);
+
+	tree.swap(stree);
+	swap(tree, stree);
+	tree.clear();
+}
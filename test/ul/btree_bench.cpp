@@ -0,0 +1,87 @@
+#include <ul/btree.hpp>
+#include <ul/rbtree.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct elem {
+	ul::uint64      key;
+	ul::rbtree_node node;
+};
+
+struct elem_less {
+	typedef void is_transparent;
+
+	bool operator()(elem const& lhs, elem const& rhs) const { return lhs.key < rhs.key; }
+	bool operator()(ul::uint64 lhs, elem const& rhs) const  { return lhs < rhs.key; }
+	bool operator()(elem const& lhs, ul::uint64 rhs) const  { return lhs.key < rhs; }
+};
+
+struct elem_key {
+	ul::uint64 operator()(elem const& e) const { return e.key; }
+};
+
+typedef ul::rbtree<elem, &elem::node, elem_less>     rbtree_type;
+typedef ul::btree<elem, ul::uint64, elem_key>         btree_type;
+typedef std::chrono::steady_clock                     clock_type;
+
+static double ns_per(clock_type::time_point start, size_t n)
+{
+	return std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+}
+
+template<class Tree>
+static void run(char const* name, std::vector<elem>& elems, std::vector<ul::uint64> const& probes)
+{
+	Tree       tree;
+	size_t     hits = 0;
+	ul::uint64 sum  = 0;
+
+	clock_type::time_point start = clock_type::now();
+	for (size_t i = 0; i < elems.size(); ++i)
+		tree.insert_unique(elems[i]);
+	double insert = ns_per(start, elems.size());
+
+	start = clock_type::now();
+	for (size_t i = 0; i < probes.size(); ++i)
+		hits += tree.find(probes[i]) != tree.end();
+	double find = ns_per(start, probes.size());
+
+	start = clock_type::now();
+	for (typename Tree::iterator i = tree.begin(); i != tree.end(); ++i)
+		sum += i->key;
+	double scan = ns_per(start, elems.size());
+
+	start = clock_type::now();
+	for (size_t i = 0; i < elems.size(); ++i)
+		tree.remove(tree.find(elems[i].key));
+	double remove = ns_per(start, elems.size());
+
+	std::printf("%10zu %-7s %9.1f %9.1f %9.1f %9.1f   (%zu %llu)\n",
+	            elems.size(), name, insert, find, scan, remove, hits, (unsigned long long) sum);
+}
+
+int main(int argc, char* argv[])
+{
+	size_t max = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : size_t(1) << 22;
+
+	std::mt19937_64 rng(42);
+
+	std::printf("%10s %-7s %9s %9s %9s %9s   (ns/op)\n", "size", "tree", "insert", "find", "scan", "remove");
+	for (size_t n = 1024; n <= max; n *= 4) {
+		std::vector<elem>       elems(n);
+		std::vector<ul::uint64> probes(size_t(1) << 20);
+
+		for (size_t i = 0; i < n; ++i)
+			elems[i].key = rng();
+		for (size_t i = 0; i < probes.size(); ++i)
+			probes[i] = elems[rng() % n].key;
+
+		run<rbtree_type>("rbtree", elems, probes);
+		run<btree_type>("btree", elems, probes);
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include <ul/hash_table.hpp>
+
+struct foo {
+	struct key { };
+
+	bool operator==(foo const& lhs) const
+	{
+		return true;
+	}
+
+	void bar() { }
+	void bar() const { }
+
+	ul::hash_table_node node;
+};
+
+struct foo_hash {
+	size_t operator()(foo const&) const      { return 0; }
+	size_t operator()(foo::key const&) const { return 0; }
+};
+
+struct foo_equal {
+	bool operator()(foo const&, foo const&) const      { return true; }
+	bool operator()(foo::key const&, foo const&) const { return true; }
+};
+
+struct disposer {
+	void operator()(foo*) const { }
+};
+
+typedef ul::hash_table<foo, &foo::node, foo_hash, foo_equal> table_type;
+
+int main()
+{
+	foo x, y;
+	table_type table;
+	table_type stable;
+	table_type const& ctable = table;
+	table_type::iterator i;
+	table_type::const_iterator ci;
+	std::pair<table_type::iterator, bool> ir;
+	size_t n;
+	bool b;
+
+	ir = table.insert_unique(x);
+	i = table.insert_equal(y);
+
+	i = table.begin();
+	i = table.end();
+	ci = ctable.begin();
+	ci = ctable.end();
+
+	i = table.find(foo::key());
+	ci = ctable.find(foo::key());
+	i = table.find(x);
+	n = ctable.count(foo::key());
+
+	table.remove(i);
+	table.remove(x);
+	b = table.remove(foo::key());
+
+	n = ctable.size();
+	n = ctable.bucket_count();
+	b = ctable.empty();
+
+	table.clear();
+	table.clear_and_dispose(disposer());
+
+	table.swap(stable);
+	swap(table, stable);
+
+	i->bar();
+	ci->bar();
+
+	return 0;
+}
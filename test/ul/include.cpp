@@ -1,7 +1,28 @@
+#include <ul/atomic_stack.hpp>
+#include <ul/avltree.hpp>
 #include <ul/base.hpp>
+#include <ul/bstree.hpp>
+#include <ul/btree.hpp>
 #include <ul/buffer.hpp>
 #include <ul/exception.hpp>
+#include <ul/executor.hpp>
+#include <ul/hash_table.hpp>
+#include <ul/index_rbtree.hpp>
+#include <ul/interval_tree.hpp>
+#include <ul/latch_tree.hpp>
 #include <ul/list.hpp>
+#include <ul/lru_cache.hpp>
 #include <ul/move.hpp>
+#include <ul/mpmc_queue.hpp>
+#include <ul/mpsc_queue.hpp>
+#include <ul/offset_rbtree.hpp>
+#include <ul/pairing_heap.hpp>
 #include <ul/rbtree.hpp>
+#include <ul/rbtree_algorithms.hpp>
+#include <ul/slist.hpp>
+#include <ul/splaytree.hpp>
+#include <ul/thread_executor.hpp>
+#include <ul/timer_queue.hpp>
+#include <ul/timing_wheel.hpp>
+#include <ul/treap.hpp>
 #include <ul/utility.hpp>
@@ -0,0 +1,73 @@
+#include <ul/index_rbtree.hpp>
+
+struct foo {
+	struct key {
+		bool operator<(foo const& lhs) const { return true; }
+		bool operator>(foo const& lhs) const { return true; }
+	};
+
+	bool operator<(foo const& lhs) const
+	{
+		return true;
+	}
+
+	void bar() { }
+	void bar() const { }
+
+	ul::index_rbtree_node node;
+};
+
+typedef ul::index_rbtree<foo, &foo::node> tree_type;
+
+int main()
+{
+	foo pool[4];
+	tree_type tree(pool);
+	tree_type stree(pool);
+	tree_type const& ctree = tree;
+	tree_type::iterator i;
+	tree_type::const_iterator ci;
+	tree_type::reverse_iterator ri;
+	tree_type::const_reverse_iterator cri;
+	std::pair<tree_type::iterator, bool> ir;
+	ul::uint32 x;
+	size_t n;
+	bool b;
+
+	i = tree.insert_equal(pool[0]);
+	ir = tree.insert_unique(pool[1]);
+
+	i = tree.begin();
+	i = tree.end();
+	--i;
+	ri = tree.rbegin();
+	ri = tree.rend();
+	ci = ctree.begin();
+	ci = ctree.end();
+	cri = ctree.rbegin();
+	cri = ctree.rend();
+
+	i = tree.find(foo::key());
+	ci = ctree.find(foo::key());
+	i = tree.lower_bound(foo::key());
+	ci = ctree.lower_bound(foo::key());
+	i = tree.upper_bound(foo::key());
+	ci = ctree.upper_bound(foo::key());
+
+	x = ctree.index_of(*i);
+	x = i.index();
+	n = ctree.size();
+	b = ctree.empty();
+
+	tree.remove(i);
+	tree.remove(pool[0]);
+	b = tree.remove(foo::key());
+
+	tree.swap(stree);
+	swap(tree, stree);
+
+	i->bar();
+	ci->bar();
+
+	return 0;
+}
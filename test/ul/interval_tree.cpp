@@ -0,0 +1,54 @@
+#include <ul/interval_tree.hpp>
+
+struct foo {
+	struct low {
+		int operator()(foo const& f) const { return f.first; }
+	};
+	struct high {
+		int operator()(foo const& f) const { return f.last; }
+	};
+
+	void bar() { }
+	void bar() const { }
+
+	int first;
+	int last;
+
+	ul::interval_tree_node<int> node;
+};
+
+typedef ul::interval_tree<foo, int, &foo::node, foo::low, foo::high> tree_type;
+
+int main()
+{
+	tree_type tree;
+	tree_type stree;
+	tree_type const& ctree = tree;
+	tree_type::range r;
+	tree_type::const_range cr;
+	tree_type::iterator i;
+	tree_type::const_iterator ci;
+	bool b;
+	foo v;
+
+	tree.insert(v);
+	tree.update(v);
+
+	r = tree.overlaps(0, 1);
+	r = tree.stab(0);
+	cr = ctree.overlaps(0, 1);
+	cr = ctree.stab(0);
+	b = ctree.overlapped(0, 1);
+
+	i = r.begin();
+	ci = cr.begin();
+	i->bar();
+	ci->bar();
+
+	tree.remove(v);
+	tree.swap(stree);
+	b = tree.empty();
+	(void)b;
+
+	return 0;
+}
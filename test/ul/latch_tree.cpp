@@ -0,0 +1,24 @@
+#include <ul/latch_tree.hpp>
+
+struct foo {
+	bool operator<(foo const& lhs) const
+	{
+		return true;
+	}
+
+	ul::latch_tree_node node;
+};
+
+int main()
+{
+	ul::latch_tree<foo, &foo::node> tree;
+	ul::latch_tree<foo, &foo::node> const& ctree = tree;
+	foo* p;
+	bool b;
+	foo v;
+
+	tree.insert(v);
+	p = ctree.find(v);
+	b = ctree.empty();
+	tree.remove(v);
+}
@@ -1,10 +1,21 @@
 #include <ul/list.hpp>
 #include <boost/ref.hpp>
+#include <functional>
+
+struct disposer {
+	void operator()(struct foo*) const { }
+};
+
+struct cloner {
+	struct foo* operator()(struct foo const&) const { return nullptr; }
+};
 
 struct foo {
 	void bar() { }
 	void bar() const { }
 
+	bool operator<(foo const&) const { return false; }
+
 	ul::list_node node;
 };
 
@@ -18,6 +29,9 @@ int main()
 	ul::list<foo, &foo::node>::const_iterator ci;
 	ul::list<foo, &foo::node>::reverse_iterator ri;
 	ul::list<foo, &foo::node>::const_reverse_iterator cri;
+	ul::list<foo, &foo::node, true> tlist;
+	ul::list<foo, &foo::node, true> tother;
+	size_t n;
 	bool b;
 	foo v;
 
@@ -49,6 +63,24 @@ int main()
 	list.remove(v);
 
 	list.reverse();
+	list.sort();
+	list.sort(std::less<foo>());
+	list.merge(slist);
+	list.merge(slist, std::less<foo>());
+	list.splice(list.begin(), slist);
+	list.splice(list.begin(), slist, slist.begin());
+	list.splice(list.begin(), slist, slist.begin(), slist.end());
+	list.splice(list.begin(), slist, slist.begin(), slist.end(), 0);
+	n = list.size();
+	tlist.push_back(v);
+	tlist.splice(tlist.end(), tother);
+	tlist.merge(tother);
+	tlist.sort();
+	n = tlist.size();
+	(void)n;
+	slist.clone_from(clist, cloner(), disposer());
+	slist.clear_and_dispose(disposer());
+	slist.clear();
 	list.swap(slist);
 	b = list.empty();
 
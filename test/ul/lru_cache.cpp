@@ -0,0 +1,53 @@
+#include <ul/lru_cache.hpp>
+
+struct foo {
+	struct key { };
+
+	void bar() { }
+
+	ul::lru_cache_node node;
+};
+
+struct foo_hash {
+	size_t operator()(foo const&) const      { return 0; }
+	size_t operator()(foo::key const&) const { return 0; }
+};
+
+struct foo_equal {
+	bool operator()(foo const&, foo const&) const      { return true; }
+	bool operator()(foo::key const&, foo const&) const { return true; }
+};
+
+struct disposer {
+	void operator()(foo*) const { }
+};
+
+struct visitor {
+	void operator()(foo& f) const { f.bar(); }
+};
+
+typedef ul::lru_cache<foo, &foo::node, foo_hash, foo_equal> cache_type;
+
+int main()
+{
+	foo x;
+	cache_type cache(1024);
+	cache_type ccache(1024, 4, ul::clock_mode);
+	cache_type const& ccache_ref = cache;
+	size_t n;
+	bool b;
+
+	b = cache.insert(x, disposer());
+	b = cache.insert(x, disposer(), visitor());
+	b = cache.find(foo::key(), visitor());
+	b = cache.remove(foo::key(), disposer());
+	b = cache.remove(x);
+	b = x.node.cached();
+
+	cache.clear_and_dispose(disposer());
+
+	n = ccache_ref.size();
+	n = ccache_ref.capacity();
+
+	return 0;
+}
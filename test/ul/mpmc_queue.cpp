@@ -0,0 +1,31 @@
+#include <ul/mpmc_queue.hpp>
+
+struct foo {
+	int bar;
+};
+
+int main()
+{
+	ul::mpmc_queue<foo> queue(1024);
+	ul::mpmc_queue<foo> const& cqueue = queue;
+	foo values[4] = { };
+	foo x = { };
+	size_t n;
+	bool b;
+
+	b = queue.try_push(x);
+	b = queue.try_push(foo());
+	queue.push(x);
+	queue.push(foo());
+	n = queue.try_push(values, 4);
+
+	b = queue.try_pop(x);
+	queue.pop(x);
+	n = queue.try_pop(values, 4);
+
+	n = cqueue.size();
+	n = cqueue.capacity();
+	b = cqueue.empty();
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+#include <ul/mpsc_queue.hpp>
+
+struct foo {
+	void bar() { }
+
+	ul::mpsc_queue_node node;
+};
+
+struct disposer {
+	void operator()(foo*) const { }
+};
+
+int main()
+{
+	ul::mpsc_queue<foo, &foo::node> queue;
+	ul::mpsc_queue<foo, &foo::node> const& cqueue = queue;
+	ul::mpsc_queue<foo, &foo::node>::pointer p;
+	bool b;
+	foo x;
+	foo y(x);
+
+	queue.push(x);
+	queue.push(y);
+
+	p = queue.pop();
+	p->bar();
+	b = cqueue.empty();
+
+	queue.clear_and_dispose(disposer());
+
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include <ul/pairing_heap.hpp>
+
+struct foo {
+	bool operator<(foo const& lhs) const
+	{
+		return true;
+	}
+
+	void bar() { }
+	void bar() const { }
+
+	ul::pairing_heap_node node;
+};
+
+typedef ul::pairing_heap<foo, &foo::node> heap_type;
+
+int main()
+{
+	foo x, y;
+	heap_type heap;
+	heap_type sheap;
+	heap_type const& cheap = heap;
+	size_t n;
+	bool b;
+
+	heap.push(x);
+	heap.push(y);
+
+	heap.top().bar();
+	cheap.top().bar();
+
+	heap.decrease(y);
+	heap.update(y);
+	heap.erase(x);
+	heap.pop();
+
+	heap.merge(sheap);
+	heap.clear();
+
+	n = cheap.size();
+	b = cheap.empty();
+
+	heap.swap(sheap);
+	swap(heap, sheap);
+
+	return 0;
+}
@@ -1,4 +1,13 @@
 #include <ul/rbtree.hpp>
+#include <ul/thread_executor.hpp>
+
+struct disposer {
+	void operator()(struct foo*) const { }
+};
+
+struct cloner {
+	struct foo* operator()(struct foo const&) const { return nullptr; }
+};
 
 struct foo {
 	struct key {
@@ -15,8 +24,15 @@ struct foo {
 	void bar() const { }
 
 	ul::rbtree_node node;
+	size_t          count;
+	int             qty;
+	int             qty_sum;
 };
 
+typedef ul::rbtree<foo, &foo::node, std::less<foo>, ul::rbtree_counter<foo, &foo::count> > counted_tree;
+typedef ul::rbtree<foo, &foo::node, std::less<foo>,
+                   ul::rbtree_aggregate<foo, int, &foo::qty, &foo::qty_sum> > summed_tree;
+
 int main()
 {
 	ul::rbtree<foo, &foo::node> tree;
@@ -27,11 +43,26 @@ int main()
 	ul::rbtree<foo, &foo::node>::reverse_iterator ri;
 	ul::rbtree<foo, &foo::node>::const_reverse_iterator cri;
 	std::pair<ul::rbtree<foo, &foo::node>::iterator, bool> ir;
+	std::pair<ul::rbtree<foo, &foo::node>::iterator, ul::rbtree<foo, &foo::node>::iterator> er;
+	std::pair<ul::rbtree<foo, &foo::node>::const_iterator, ul::rbtree<foo, &foo::node>::const_iterator> cer;
+	counted_tree otree;
+	counted_tree const& cotree = otree;
+	counted_tree::iterator oi;
+	counted_tree::const_iterator coi;
+	summed_tree atree;
+	size_t n;
+	int q;
 	bool b;
 	foo v;
+	foo::key keys[2];
+	ul::rbtree<foo, &foo::node>::iterator is[2];
+	ul::rbtree<foo, &foo::node>::const_iterator cis[2];
 
 	i = tree.insert_equal(v);
 	ir = tree.insert_unique(v);
+	i = tree.insert_equal(i, v);
+	ir = tree.insert_unique(i, v);
+	stree.assign_sorted(&v, &v + 1);
 
 	i = tree.begin();
 	i = tree.end();
@@ -41,14 +72,59 @@ int main()
 	ci = ctree.end();
 	cri = ctree.rbegin();
 	cri = ctree.rend();
+	--i;
+	n = ctree.size();
 
 	i = tree.find(foo::key());
 	ci = ctree.find(foo::key());
+	tree.find_many(keys, 2, is);
+	ctree.find_many(keys, 2, cis);
+
+	i = tree.lower_bound(foo::key());
+	i = tree.upper_bound(foo::key());
+	ci = ctree.lower_bound(foo::key());
+	ci = ctree.upper_bound(foo::key());
+	er = tree.equal_range(foo::key());
+	cer = ctree.equal_range(foo::key());
+	n = ctree.count(foo::key());
 
 	tree.remove(i);
 	tree.remove(v);
 	tree.remove(foo::key());
 
+	oi = otree.insert_equal(v);
+	oi = otree.nth(0);
+	coi = cotree.nth(0);
+	n = otree.rank(oi);
+	n = cotree.rank(v);
+	n = cotree.size();
+	n = cotree.accumulate_below(foo::key(), 0);
+	otree.remove(v);
+	(void)n;
+
+	atree.insert_unique(v);
+	atree.update(v);
+	q = atree.accumulate_below(foo::key(), 0);
+	atree.remove(v);
+	(void)q;
+
+	tree.split(foo::key(), stree);
+	tree.join(stree);
+	stree.join(tree, v, stree);
+
+	ul::thread_executor exec;
+	tree.unite(stree, disposer());
+	tree.unite(stree, disposer(), exec);
+	tree.intersect(ctree, disposer());
+	tree.intersect(stree, disposer(), exec);
+	tree.subtract(ctree, disposer());
+	tree.subtract(stree, disposer(), exec);
+
+	stree.clone_from(ctree, cloner(), disposer());
+	otree.clone_from(cotree, cloner(), disposer());
+	stree.clear_and_dispose(disposer());
+	stree.clear();
+
 	tree.swap(stree);
 	b = tree.empty();
 
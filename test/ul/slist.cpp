@@ -0,0 +1,59 @@
+#include <ul/slist.hpp>
+
+struct disposer {
+	void operator()(struct foo*) const { }
+};
+
+struct foo {
+	void bar() { }
+	void bar() const { }
+
+	ul::slist_node node;
+};
+
+int main()
+{
+	ul::slist<foo, &foo::node> list;
+	ul::slist<foo, &foo::node> other;
+	ul::slist<foo, &foo::node> const& clist = list;
+	ul::slist<foo, &foo::node>::pointer p;
+	ul::slist<foo, &foo::node>::iterator i;
+	ul::slist<foo, &foo::node>::const_iterator ci;
+	bool b;
+	foo v;
+
+	list.push_back(v);
+	list.push_front(v);
+
+	p = list.pop_front();
+
+	foo& r1 = list.front();
+	foo& r2 = list.back();
+	foo const& r3 = clist.front();
+	foo const& r4 = clist.back();
+	(void)r1;
+	(void)r2;
+	(void)r3;
+	(void)r4;
+
+	i = list.before_begin();
+	i = list.begin();
+	i = list.end();
+	ci = clist.before_begin();
+	ci = clist.begin();
+	ci = clist.end();
+
+	i = list.insert_after(list.before_begin(), v);
+	i = list.erase_after(list.before_begin());
+
+	other.clear_and_dispose(disposer());
+	other.clear();
+	list.swap(other);
+	swap(list, other);
+	b = list.empty();
+
+	i->bar();
+	ci->bar();
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+#include <ul/splaytree.hpp>
+
+struct foo {
+	struct key {
+		bool operator<(foo const& lhs) const { return true; }
+		bool operator>(foo const& lhs) const { return true; }
+	};
+
+	bool operator<(foo const& lhs) const
+	{
+		return true;
+	}
+
+	void bar() { }
+	void bar() const { }
+
+	ul::rbtree_node node;
+};
+
+typedef ul::splaytree<foo, &foo::node> tree_type;
+
+int main()
+{
+	foo x, y;
+	tree_type tree;
+	tree_type stree;
+	tree_type const& ctree = tree;
+	tree_type::iterator i;
+	tree_type::const_iterator ci;
+	tree_type::reverse_iterator ri;
+	tree_type::const_reverse_iterator cri;
+	std::pair<tree_type::iterator, bool> ir;
+	size_t n;
+	bool b;
+
+	i = tree.insert_equal(x);
+	ir = tree.insert_unique(y);
+
+	i = tree.begin();
+	i = tree.end();
+	--i;
+	ri = tree.rbegin();
+	ri = tree.rend();
+	ci = ctree.begin();
+	ci = ctree.end();
+	cri = ctree.rbegin();
+	cri = ctree.rend();
+
+	i = tree.find(foo::key());
+	ci = ctree.find(foo::key());
+	i = tree.lower_bound(foo::key());
+	ci = ctree.lower_bound(foo::key());
+	i = tree.upper_bound(foo::key());
+	ci = ctree.upper_bound(foo::key());
+
+	tree.splay(x);
+
+	n = ctree.size();
+	b = ctree.empty();
+
+	tree.remove(i);
+	tree.remove(x);
+	b = tree.remove(foo::key());
+	tree.clear();
+
+	tree.swap(stree);
+	swap(tree, stree);
+
+	i->bar();
+	ci->bar();
+
+	return 0;
+}
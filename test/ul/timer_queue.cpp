@@ -0,0 +1,46 @@
+#include <ul/timer_queue.hpp>
+
+struct foo {
+	void bar() { }
+
+	ul::timer_node timer;
+};
+
+struct callback {
+	void operator()(foo& f) const { f.bar(); }
+};
+
+typedef ul::timer_queue<foo, &foo::timer> queue_type;
+
+int main()
+{
+	foo x;
+	queue_type queue;
+	queue_type squeue;
+	queue_type const& cqueue = queue;
+	queue_type::time_point t = queue_type::clock::now();
+	queue_type::pointer p;
+	size_t n;
+	bool b;
+
+	queue.schedule(x, t);
+	b = queue.cancel(x);
+	b = x.timer.scheduled();
+	t = x.timer.deadline();
+
+	p = cqueue.top();
+	t = cqueue.next_deadline();
+	n = queue.expire_until(t, callback());
+
+	n = cqueue.size();
+	b = cqueue.empty();
+
+#if defined(__linux)
+	queue.arm(-1);
+#endif
+
+	queue.swap(squeue);
+	swap(queue, squeue);
+
+	return 0;
+}
@@ -0,0 +1,36 @@
+#include <ul/timing_wheel.hpp>
+
+struct foo {
+	void bar() { }
+
+	ul::timing_wheel_node timer;
+};
+
+struct callback {
+	void operator()(foo& f) const { f.bar(); }
+};
+
+typedef ul::timing_wheel<foo, &foo::timer> wheel_type;
+
+int main()
+{
+	foo x;
+	wheel_type wheel;
+	wheel_type const& cwheel = wheel;
+	ul::uint64 t;
+	size_t n;
+	bool b;
+
+	wheel.schedule(x, 10);
+	b = wheel.cancel(x);
+	b = x.timer.scheduled();
+	t = x.timer.expires();
+
+	n = wheel.advance(10, callback());
+	t = cwheel.now();
+
+	n = cwheel.size();
+	b = cwheel.empty();
+
+	return 0;
+}
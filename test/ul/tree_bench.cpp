@@ -0,0 +1,105 @@
+#include <ul/avltree.hpp>
+#include <ul/rbtree.hpp>
+#include <ul/splaytree.hpp>
+#include <ul/treap.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct elem {
+	ul::uint64      key;
+	ul::rbtree_node node;
+};
+
+struct elem_less {
+	typedef void is_transparent;
+
+	bool operator()(elem const& lhs, elem const& rhs) const { return lhs.key < rhs.key; }
+	bool operator()(ul::uint64 lhs, elem const& rhs) const  { return lhs < rhs.key; }
+	bool operator()(elem const& lhs, ul::uint64 rhs) const  { return lhs.key < rhs; }
+};
+
+typedef ul::rbtree<elem, &elem::node, elem_less>    rbtree_type;
+typedef ul::avltree<elem, &elem::node, elem_less>   avltree_type;
+typedef ul::splaytree<elem, &elem::node, elem_less> splaytree_type;
+typedef ul::treap<elem, &elem::node, elem_less>     treap_type;
+typedef std::chrono::steady_clock                   clock_type;
+
+static double ns_per(clock_type::time_point start, size_t n)
+{
+	return std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+}
+
+template<class Tree>
+static size_t lookup(Tree& tree, std::vector<ul::uint64> const& probes)
+{
+	size_t hits = 0;
+
+	for (size_t i = 0; i < probes.size(); ++i)
+		hits += tree.find(probes[i]) != tree.end();
+
+	return hits;
+}
+
+template<class Tree>
+static void run(char const* name, std::vector<elem>& elems,
+                std::vector<ul::uint64> const& uniform, std::vector<ul::uint64> const& skewed)
+{
+	Tree   tree;
+	size_t hits = 0;
+
+	clock_type::time_point start = clock_type::now();
+	for (size_t i = 0; i < elems.size(); ++i)
+		tree.insert_unique(elems[i]);
+	double insert = ns_per(start, elems.size());
+
+	start = clock_type::now();
+	hits += lookup(tree, uniform);
+	double find = ns_per(start, uniform.size());
+
+	start = clock_type::now();
+	hits += lookup(tree, skewed);
+	double find_skewed = ns_per(start, skewed.size());
+
+	start = clock_type::now();
+	for (size_t i = 0; i < elems.size(); ++i)
+		tree.remove(tree.find(elems[i].key));
+	double remove = ns_per(start, elems.size());
+
+	std::printf("%10zu %-9s %9.1f %9.1f %9.1f %9.1f   (%zu)\n",
+	            elems.size(), name, insert, find, find_skewed, remove, hits);
+}
+
+int main(int argc, char* argv[])
+{
+	size_t max = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : size_t(1) << 22;
+
+	std::mt19937_64 rng(42);
+
+	std::printf("%10s %-9s %9s %9s %9s %9s   (ns/op)\n", "size", "tree", "insert", "find", "skewed", "remove");
+	for (size_t n = 1024; n <= max; n *= 4) {
+		std::vector<elem>       elems(n);
+		std::vector<ul::uint64> uniform(size_t(1) << 20);
+		std::vector<ul::uint64> skewed(size_t(1) << 20);
+
+		for (size_t i = 0; i < n; ++i)
+			elems[i].key = rng();
+		for (size_t i = 0; i < uniform.size(); ++i)
+			uniform[i] = elems[rng() % n].key;
+
+		//
+		// Nine out of ten lookups go to one percent of the elements
+		//
+		for (size_t i = 0; i < skewed.size(); ++i)
+			skewed[i] = elems[rng() % 10 ? rng() % (n / 100 + 1) : rng() % n].key;
+
+		run<rbtree_type>("rbtree", elems, uniform, skewed);
+		run<avltree_type>("avltree", elems, uniform, skewed);
+		run<splaytree_type>("splaytree", elems, uniform, skewed);
+		run<treap_type>("treap", elems, uniform, skewed);
+	}
+
+	return 0;
+}